@@ -102,6 +102,78 @@ const entry_base =
           "For greater efficiency, these events can be disabled, for example if only using the plugin States system to handle input device updates."
 			},
     },
+    {
+      name: "Merge Rapid Axis Movements",
+      type: "switch",
+      default: "on",
+      readOnly: false,
+			tooltip: {
+				body: "When enabled, multiple movements of the same controller axis (or trackball) which arrive within one device update interval are merged into one report with the latest value. " +
+          "This greatly reduces the number of State and Event updates sent to Touch Portal while an axis is moving. Button and hat (POV) changes are never merged."
+			},
+    },
+    {
+      name: "High Priority Input Thread",
+      type: "switch",
+      default: "off",
+      readOnly: false,
+			tooltip: {
+				body: "When enabled, the thread which reads controller input runs at a higher priority than the rest of the plugin. " +
+          "This may reduce input latency on a busy system."
+			},
+    },
+    {
+      name: "Latency Statistics Interval (seconds, 0 = off)",
+      type: "number",
+      default: "0",
+      minValue: 0,
+      maxValue: 3600,
+      readOnly: false,
+			tooltip: {
+				body: "When greater than zero, the plugin measures how long device input takes to travel from the system to Touch Portal, and reports the results at this interval. " +
+          "Latency percentiles (50th / 95th / 99th / maximum, in milliseconds) are logged and sent as States in the \"Input Latency\" category, " +
+          "broken down by processing stage, event type and device. Measurement adds a small overhead, so it is best left off when not needed."
+			},
+    },
+    {
+      name: "Output Backlog Limit (KB, 0 = unlimited)",
+      type: "number",
+      default: "256",
+      minValue: 0,
+      maxValue: 65536,
+      readOnly: false,
+			tooltip: {
+				body: "If Touch Portal falls behind in reading updates from the plugin and the amount of unsent data grows past this limit, the plugin switches to a reduced output mode " +
+          "until the backlog drops to one quarter of the limit. In this mode only the latest value of each axis/motion/scroll State is sent, and only the latest Event for each of those controls. " +
+          "Button, hat and key changes are never merged or dropped. Set to 0 to disable this protection."
+			},
+    },
+    {
+      name: "Axis & Position Decimal Places (-1 = full precision)",
+      type: "number",
+      default: "-1",
+      minValue: -1,
+      maxValue: 9,
+      readOnly: false,
+			tooltip: {
+				body: "Number of decimal places to use for axis, motion and scroll values in States and Events, with any trailing zeros removed. " +
+          "Fewer decimal places make for shorter messages to Touch Portal. " +
+          "The default of -1 sends the shortest exact value, eg. \"0.125\" or \"0.1\"."
+			},
+    },
+    {
+      name: "Axis & Motion Max. Updates per Second (0 = unlimited)",
+      type: "number",
+      default: "0",
+      minValue: 0,
+      maxValue: 1000,
+      readOnly: false,
+			tooltip: {
+				body: "Limits how often the State and Event of each individual axis, motion or scroll control are sent to Touch Portal, eg. 30 times per second. " +
+          "The first change after a control has been still is sent right away, and the last value is always sent once the control stops moving, " +
+          "so only intermediate values are skipped. Buttons, hats and keys are never limited. Set to 0 to send every change."
+			},
+    },
   ],
   categories: [
     {
@@ -536,13 +608,17 @@ function addSystemActions()
       "Toggle Reporting",
       "Refresh Report",
       "Clear Report Filter",
+      "Send States & Events",
+      "Send States Only",
+      "Send Events Only",
     ], "select an action..."),
     makeChoiceData(id + ".device", "Device Name", [], "select a device..."),
   ]
   addDeviceExpressionFields(id, format, data);
   addActionWithLines(id, "Device Control Actions",
     "Perform an action on one or more devices.\n" +
-      "A specific device which is currently connected can selected directly, or an expression may be used to select device(s) based on a name or type.",
+      "A specific device which is currently connected can selected directly, or an expression may be used to select device(s) based on a name or type.\n" +
+      "The \"Send ...\" actions choose whether a device's input is sent as States, Events or both (if also enabled in the plugin settings).",
     format, data
   );
 
@@ -564,6 +640,29 @@ function addSystemActions()
     format, data
   );
 
+  id = "axis";
+  format = ["Set conditioning of axes {1} on Device: {0}"];
+  data = [
+    makeChoiceData(id + ".device", "Device Name", [], "select a device..."),
+    makeTextData(id + ".axes", "Axis Number(s)", "*"),
+  ]
+  addDeviceExpressionFields(id, format, data);
+  format.push("Center Deadzone {5}% Edge Deadzone {6}% Hysteresis {7}% Quantize to {8} steps (0 = off)");
+  data.push(
+    makeNumericData(id + ".center", "Center Deadzone %", 0, 0, 90),
+    makeNumericData(id + ".edge", "Edge Deadzone %", 0, 0, 45),
+    makeNumericData(id + ".hysteresis", "Hysteresis %", 0, 0, 100),
+    makeNumericData(id + ".steps", "Quantize Steps", 0, 0, 65535, false),
+  );
+  addActionWithLines(id, "Set Controller Axis Conditioning",
+    "Filter controller axis values before they are reported, for example to ignore noise from worn potentiometers.\n" +
+      "Axis numbers can be a list and/or ranges of axes like '1-4, 6', or '*' for all axes of the device (specific axis settings take precedence).\n" +
+      "Deadzones ignore small movements around the center and/or ends of the axis range, and the remaining range is scaled to cover the full 0-100%. " +
+      "Hysteresis requires a minimum change from the last reported value before reporting a new one. Quantizing rounds values to a fixed number of steps. " +
+      "Set all values to zero to remove conditioning from the axes. Settings are saved per device name.",
+    format, data
+  );
+
   id = "default";
   addAction(id, "Set a Default Device For Type",
     "Assign a specific device to be the default for a particular type. This allows using the \"Default ...\" type selections in the \"Device Control\" and \"Device Report Filter\" plugin actions.\n" +
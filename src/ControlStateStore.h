@@ -0,0 +1,203 @@
+/*
+Device Input Plugin for Touch Portal
+Copyright Maxim Paperno; all rights reserved.
+
+This file may be used under the terms of the GNU
+General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+A copy of the GNU General Public License is available at <http://www.gnu.org/licenses/>.
+
+This project may also use 3rd-party Open Source software under the terms
+of their respective licenses. The copyright notice above does not apply
+to any 3rd-party components used within.
+*/
+
+#pragma once
+
+#include <QList>
+#include <QMutex>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include "device/events.h"
+
+// Last reported values of device controls, stored in flat arrays indexed by device handle, event type and control index.
+// Values are kept in raw numeric form (see rawValue()) so change detection is a single integer comparison.
+//
+// There is one writer thread (the one handling device events), which updates values without any locking. Other threads may read
+// values with snapshot(), which returns a consistent copy of one device's values. Array (re)allocation by the writer is rare
+// (the first time a device or a higher control index is seen) and is the only time the writer takes a lock, to keep readers from
+// accessing freed memory.
+class ControlStateStore
+{
+	public:
+		// Raw value for a control which has never been reported. This is a NaN bit pattern for float values, so never a real value.
+		static constexpr uint64_t NoValue = ~0ULL;
+
+		struct ControlValue
+		{
+			Devices::EventType type;
+			uint16_t index;
+			uint64_t value;
+		};
+
+		// Returns the raw value of an event: the state of a button/key, value of a hat, or the float bits of an axis value
+		// or x/y coordinates, with the x value in the lower 32 bits. With a `precision` >= 0 float values are first rounded
+		// to that many decimal places, so changes which wouldn't show in the formatted value aren't detected as changes.
+		static uint64_t rawValue(const Devices::EventRecord &ev, int precision = -1)
+		{
+			switch (ev.type) {
+				case Devices::EventType::Event_Axis:   return std::bit_cast<uint32_t>(rounded(ev.axis.value, precision));
+				case Devices::EventType::Event_Button: return ev.button.down;
+				case Devices::EventType::Event_Hat:    return uint32_t(ev.hat.value);
+				case Devices::EventType::Event_Key:    return ev.key.down;
+				case Devices::EventType::Event_Motion: return packFloats(rounded(ev.motion.x, precision), rounded(ev.motion.y, precision));
+				case Devices::EventType::Event_Scroll: return packFloats(rounded(ev.scroll.relX, precision), rounded(ev.scroll.relY, precision));
+				default: return 0;
+			}
+		}
+
+		ControlStateStore() = default;
+		~ControlStateStore() {
+			for (DeviceValues *dv : m_devices)
+				delete dv;
+		}
+
+		// Writer side. Stores `value` for a control and returns the previous value, or NoValue if there was none.
+		uint64_t exchange(Devices::DeviceHandle device, Devices::EventType type, uint16_t index, uint64_t value)
+		{
+			TypeValues &tv = typeValues(device, type, index);
+			DeviceValues *dv = m_devices[device];
+			const uint64_t prev = tv.values[index].load(std::memory_order_relaxed);
+			if (prev != value) {
+				beginWrite(dv);
+				tv.values[index].store(value, std::memory_order_relaxed);
+				endWrite(dv);
+			}
+			return prev;
+		}
+
+		// Writer side. Returns the current value of a control, or NoValue if there is none.
+		uint64_t value(Devices::DeviceHandle device, Devices::EventType type, uint16_t index) const
+		{
+			if (device >= m_devices.size() || !m_devices[device])
+				return NoValue;
+			const TypeValues &tv = m_devices[device]->types[type];
+			return index < tv.size ? tv.values[index].load(std::memory_order_relaxed) : NoValue;
+		}
+
+		// Writer side. Forgets all values of a device, eg. when its state IDs change.
+		void clear(Devices::DeviceHandle device)
+		{
+			if (device >= m_devices.size() || !m_devices[device])
+				return;
+			DeviceValues *dv = m_devices[device];
+			beginWrite(dv);
+			for (TypeValues &tv : dv->types) {
+				for (std::size_t i = 0; i < tv.size; ++i)
+					tv.values[i].store(NoValue, std::memory_order_relaxed);
+			}
+			endWrite(dv);
+		}
+
+		// Reader side, safe to call from any thread. Returns a consistent copy of all the known control values of a device.
+		QList<ControlValue> snapshot(Devices::DeviceHandle device) const
+		{
+			QList<ControlValue> ret;
+			const QMutexLocker lock(&m_mutex);
+			if (device >= m_devices.size() || !m_devices[device])
+				return ret;
+			const DeviceValues *dv = m_devices[device];
+			uint32_t seq;
+			do {
+				ret.clear();
+				while ((seq = dv->seq.load(std::memory_order_acquire)) & 1)
+					;
+				for (int t = 0; t < Devices::EventType::EVENT_TYPE_ENUM_MAX; ++t) {
+					const TypeValues &tv = dv->types[t];
+					for (std::size_t i = 0; i < tv.size; ++i) {
+						const uint64_t v = tv.values[i].load(std::memory_order_relaxed);
+						if (v != NoValue)
+							ret.append({ Devices::EventType(t), uint16_t(i), v });
+					}
+				}
+				std::atomic_thread_fence(std::memory_order_acquire);
+			} while (dv->seq.load(std::memory_order_relaxed) != seq);
+			return ret;
+		}
+
+	private:
+		Q_DISABLE_COPY(ControlStateStore)
+
+		struct TypeValues
+		{
+			std::unique_ptr<std::atomic_uint64_t[]> values;
+			std::size_t size {0};
+		};
+		struct DeviceValues
+		{
+			std::atomic_uint32_t seq {0};  // odd while a write is in progress
+			TypeValues types[Devices::EventType::EVENT_TYPE_ENUM_MAX];
+		};
+
+		// Rounds to `precision` decimal places (up to 9), the same way as FloatChars does, or returns `v` as-is if `precision` < 0.
+		// The scaled value is exact in a double for any float, so ties are rounded to even like the formatted text.
+		static float rounded(float v, int precision)
+		{
+			static constexpr double scales[] { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9 };
+			if (precision < 0)
+				return v;
+			const double scale = scales[std::min(precision, 9)];
+			// adding zero turns -0 into 0, which is also how FloatChars formats it
+			return float(std::nearbyint(double(v) * scale) / scale) + 0.0f;
+		}
+
+		static uint64_t packFloats(float x, float y) {
+			return std::bit_cast<uint32_t>(x) | (uint64_t(std::bit_cast<uint32_t>(y)) << 32);
+		}
+
+		static void beginWrite(DeviceValues *dv) {
+			dv->seq.store(dv->seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+		}
+		static void endWrite(DeviceValues *dv) {
+			dv->seq.store(dv->seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+		}
+
+		// Returns the values array for a device and event type, allocating or growing storage as needed to hold `index`.
+		TypeValues &typeValues(Devices::DeviceHandle device, Devices::EventType type, uint16_t index)
+		{
+			if (device < m_devices.size() && m_devices[device]) {
+				TypeValues &tv = m_devices[device]->types[type];
+				if (index < tv.size)
+					return tv;
+			}
+
+			const QMutexLocker lock(&m_mutex);
+			if (device >= m_devices.size())
+				m_devices.resize(device + 1, nullptr);
+			if (!m_devices[device])
+				m_devices[device] = new DeviceValues();
+			TypeValues &tv = m_devices[device]->types[type];
+			const std::size_t size = std::max<std::size_t>(std::bit_ceil(std::size_t(index) + 1), 16);
+			std::unique_ptr<std::atomic_uint64_t[]> values(new std::atomic_uint64_t[size]);
+			for (std::size_t i = 0; i < size; ++i)
+				values[i].store(i < tv.size ? tv.values[i].load(std::memory_order_relaxed) : NoValue, std::memory_order_relaxed);
+			tv.values.swap(values);
+			tv.size = size;
+			return tv;
+		}
+
+		mutable QMutex m_mutex;  // guards storage allocation against concurrent readers
+		std::vector<DeviceValues *> m_devices;  // indexed by device handle
+};
@@ -0,0 +1,81 @@
+/*
+Device Input Plugin for Touch Portal
+Copyright Maxim Paperno; all rights reserved.
+
+This file may be used under the terms of the GNU
+General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+A copy of the GNU General Public License is available at <http://www.gnu.org/licenses/>.
+
+This project may also use 3rd-party Open Source software under the terms
+of their respective licenses. The copyright notice above does not apply
+to any 3rd-party components used within.
+*/
+
+#pragma once
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QLocale>
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+// Decimal (non-exponent) text of a float value, formatted into a stack buffer.
+// By default the value is formatted with the shortest representation which round-trips to the same float. With a `precision` >= 0
+// the value is rounded to that many decimal places, with any trailing zeros (and decimal point) removed, eg. 0.5 instead of 0.500.
+class FloatChars
+{
+	public:
+		static constexpr int MaxPrecision = 9;
+
+		explicit FloatChars(float value, int precision = -1)
+		{
+			char *const end = m_buf + sizeof(m_buf);
+#if defined(__cpp_lib_to_chars)
+			const std::to_chars_result res = precision < 0 ?
+				std::to_chars(m_buf, end, value, std::chars_format::fixed) :
+				std::to_chars(m_buf, end, value, std::chars_format::fixed, std::min(precision, MaxPrecision));
+			m_len = res.ec == std::errc() ? uint8_t(res.ptr - m_buf) : 0;
+#else
+			// no floating point std::to_chars() in this standard library (eg. older macOS targets)
+			const QByteArray ba = precision < 0 ?
+				QByteArray::number(value, 'f', QLocale::FloatingPointShortest) :
+				QByteArray::number(value, 'f', std::min(precision, MaxPrecision));
+			m_len = uint8_t(std::min<qsizetype>(ba.size(), end - m_buf));
+			std::memcpy(m_buf, ba.constData(), m_len);
+#endif
+			if (precision >= 0)
+				trimZeros();
+		}
+
+		QByteArrayView view() const { return QByteArrayView(m_buf, m_len); }
+		operator QByteArrayView() const { return view(); }
+		QByteArray toByteArray() const { return QByteArray(m_buf, m_len); }
+
+	private:
+		void trimZeros()
+		{
+			if (std::memchr(m_buf, '.', m_len)) {
+				while (m_len && m_buf[m_len - 1] == '0')
+					--m_len;
+				if (m_len && m_buf[m_len - 1] == '.')
+					--m_len;
+			}
+			// values rounded to zero from below would otherwise show as "-0" (also with a precision of 0, which has no decimal point)
+			if (m_len == 2 && m_buf[0] == '-' && m_buf[1] == '0') {
+				m_buf[0] = '0';
+				m_len = 1;
+			}
+		}
+
+		// Longest possible result is a negative denormal in shortest format: sign + "0." + 44 zeros + significant digits.
+		char m_buf[64];
+		uint8_t m_len {0};
+};
@@ -0,0 +1,137 @@
+/*
+Device Input Plugin for Touch Portal
+Copyright Maxim Paperno; all rights reserved.
+
+This file may be used under the terms of the GNU
+General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+A copy of the GNU General Public License is available at <http://www.gnu.org/licenses/>.
+
+This project may also use 3rd-party Open Source software under the terms
+of their respective licenses. The copyright notice above does not apply
+to any 3rd-party components used within.
+*/
+
+#pragma once
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QList>
+#include <QPair>
+#include <QString>
+#include <algorithm>
+#include <initializer_list>
+
+// Pre-serialized JSON of a TP `triggerEvent` message, with the event ID, constant local states (eg. device name) and all the keys
+// already encoded. Variable local state values are filled into slots when building a message, which only requires escaping the values.
+//
+// The output is byte-identical to serializing the equivalent QJsonObject with QJsonDocument::Compact: keys are sorted (all keys
+// used here are ASCII, so byte order matches QJsonObject's ordering) and strings are escaped the same way as Qt's JSON writer does.
+class JsonMessageTemplate
+{
+	public:
+		JsonMessageTemplate() = default;
+
+		// `constStates` are local state key/value pairs which are the same in every message; `valueKeys` are the keys for variable values,
+		// in the same order the values are later passed to build().
+		JsonMessageTemplate(const QByteArray &eventId, const QList<QPair<QByteArray, QByteArray>> &constStates, const QList<QByteArray> &valueKeys)
+		{
+			struct Entry { QByteArray key; QByteArray value; int slot; };
+			QList<Entry> entries;
+			entries.reserve(constStates.size() + valueKeys.size());
+			for (const auto &st : constStates)
+				entries.append({ st.first, st.second, -1 });
+			for (int i = 0; i < valueKeys.size(); ++i)
+				entries.append({ valueKeys[i], QByteArray(), i });
+			std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) { return a.key < b.key; });
+
+			QByteArray frag = "{\"eventId\":\"" + escaped(eventId) + "\",\"states\":{";
+			for (int i = 0; i < entries.size(); ++i) {
+				const Entry &e = entries[i];
+				if (i)
+					frag += ',';
+				frag += '"' + escaped(e.key) + "\":\"";
+				if (e.slot < 0) {
+					frag += escaped(e.value) + '"';
+					continue;
+				}
+				m_fragments.append(frag);
+				m_slots.append(e.slot);
+				frag = "\"";
+			}
+			frag += "},\"type\":\"triggerEvent\"}";
+			m_fragments.append(frag);
+
+			for (const QByteArray &f : std::as_const(m_fragments))
+				m_fixedSize += f.size();
+		}
+
+		bool isNull() const { return m_fragments.isEmpty(); }
+
+		// Returns the complete message with `values` (UTF-8) filled in; the number and order of values must match the `valueKeys` of the constructor.
+		QByteArray build(std::initializer_list<QByteArrayView> values) const
+		{
+			const QByteArrayView *vals = values.begin();
+			qsizetype size = m_fixedSize;
+			for (const QByteArrayView &v : values)
+				size += v.size() + 8;  // leave some room for escapes
+			QByteArray ret;
+			ret.reserve(size);
+			ret.append(m_fragments.first());
+			for (int i = 0; i < m_slots.size(); ++i) {
+				appendEscaped(ret, vals[m_slots[i]]);
+				ret.append(m_fragments[i + 1]);
+			}
+			return ret;
+		}
+
+		// Appends a UTF-8 string to `out` escaped for use inside a JSON string, exactly like Qt's JSON writer.
+		static void appendEscaped(QByteArray &out, QByteArrayView str)
+		{
+			static constexpr char hex[] = "0123456789abcdef";
+			// Qt converts the UTF-8 values to UTF-16 and back, which replaces any invalid sequences; only do that when needed.
+			if (!str.isValidUtf8()) {
+				appendEscaped(out, QString::fromUtf8(str).toUtf8());
+				return;
+			}
+			for (const char c : str) {
+				const uchar u = uchar(c);
+				if (u >= 0x20 && u != '"' && u != '\\') {
+					out.append(c);
+					continue;
+				}
+				out.append('\\');
+				switch (u) {
+					case '"':  out.append('"');  break;
+					case '\\': out.append('\\'); break;
+					case '\b': out.append('b');  break;
+					case '\f': out.append('f');  break;
+					case '\n': out.append('n');  break;
+					case '\r': out.append('r');  break;
+					case '\t': out.append('t');  break;
+					default:
+						out.append("u00", 3).append(hex[u >> 4]).append(hex[u & 0xF]);
+						break;
+				}
+			}
+		}
+
+		static QByteArray escaped(QByteArrayView str)
+		{
+			QByteArray ret;
+			ret.reserve(str.size());
+			appendEscaped(ret, str);
+			return ret;
+		}
+
+	private:
+		QList<QByteArray> m_fragments;  // constant parts between value slots; always one more than slots
+		QList<int> m_slots;             // value index for each slot, in output order
+		qsizetype m_fixedSize {0};
+};
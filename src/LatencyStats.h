@@ -0,0 +1,206 @@
+/*
+Device Input Plugin for Touch Portal
+Copyright Maxim Paperno; all rights reserved.
+
+This file may be used under the terms of the GNU
+General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+A copy of the GNU General Public License is available at <http://www.gnu.org/licenses/>.
+
+This project may also use 3rd-party Open Source software under the terms
+of their respective licenses. The copyright notice above does not apply
+to any 3rd-party components used within.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+
+#include "device/events.h"
+
+// Lock-free log-linear latency histogram with microsecond resolution. Each power of 2 range is split into
+// 8 linear sub-buckets, which bounds the relative error of reported percentiles to 12.5%.
+// Values can be recorded from any thread.
+class LatencyHistogram
+{
+	public:
+		static constexpr int SubBucketBits = 3;
+		static constexpr int SubBucketCount = 1 << SubBucketBits;
+		static constexpr int MaxExponent = 26;  // ~67s
+		static constexpr int BucketCount = (MaxExponent + 1) * SubBucketCount;
+
+		// Percentile values are upper bounds of the respective bucket, all in microseconds.
+		struct Summary
+		{
+			uint64_t count {0};
+			uint64_t p50 {0};
+			uint64_t p95 {0};
+			uint64_t p99 {0};
+			uint64_t max {0};
+		};
+
+		void record(uint64_t us)
+		{
+			m_buckets[bucketIndex(us)].fetch_add(1, std::memory_order_relaxed);
+			uint64_t prev = m_max.load(std::memory_order_relaxed);
+			while (us > prev && !m_max.compare_exchange_weak(prev, us, std::memory_order_relaxed))
+				;
+		}
+
+		// Returns a summary of all values recorded since the last call and resets the histogram.
+		Summary takeSummary()
+		{
+			Summary s;
+			std::array<uint32_t, BucketCount> counts;
+			for (int i = 0; i < BucketCount; ++i)
+				s.count += (counts[i] = m_buckets[i].exchange(0, std::memory_order_relaxed));
+			s.max = m_max.exchange(0, std::memory_order_relaxed);
+			if (!s.count)
+				return s;
+
+			const uint64_t p50 = (s.count * 50 + 99) / 100, p95 = (s.count * 95 + 99) / 100, p99 = (s.count * 99 + 99) / 100;
+			uint64_t n = 0;
+			for (int i = 0; i < BucketCount; ++i) {
+				if (!counts[i])
+					continue;
+				n += counts[i];
+				const uint64_t ub = std::min(bucketUpperBound(i), s.max);
+				if (!s.p50 && n >= p50)
+					s.p50 = ub;
+				if (!s.p95 && n >= p95)
+					s.p95 = ub;
+				if (n >= p99) {
+					s.p99 = ub;
+					break;
+				}
+			}
+			return s;
+		}
+
+	private:
+		static int bucketIndex(uint64_t v)
+		{
+			if (v < SubBucketCount)
+				return int(v);
+			const int shift = int(std::bit_width(v)) - 1 - SubBucketBits;
+			const int idx = ((shift + 1) << SubBucketBits) + int((v >> shift) & (SubBucketCount - 1));
+			return std::min(idx, BucketCount - 1);
+		}
+
+		static uint64_t bucketUpperBound(int idx)
+		{
+			if (idx < SubBucketCount)
+				return idx;
+			const int shift = (idx >> SubBucketBits) - 1;
+			return ((uint64_t(SubBucketCount + (idx & (SubBucketCount - 1))) + 1) << shift) - 1;
+		}
+
+		std::array<std::atomic_uint32_t, BucketCount> m_buckets {};
+		std::atomic_uint64_t m_max {0};
+};
+
+// Collects device input event latency statistics for each processing stage, event type and device.
+// Stage times are taken at: event receipt from the OS (EventRecord::steadyTime), DeviceManager dispatch,
+// end of Plugin processing, and after the resulting messages have been handed to the TP client socket.
+class LatencyStats
+{
+	public:
+		enum Stage : uint8_t {
+			LS_Queue,  // receipt -> dispatch (input polling, coalescing and queue wait)
+			LS_Plugin,    // dispatch -> processed
+			LS_Socket,    // processed -> written to socket
+			LS_Total,     // receipt -> written to socket
+
+			LS_ENUM_MAX
+		};
+
+		static constexpr int MaxDevices = 256;
+
+		// Timing data for one device event frame, passed from the Plugin to the client thread.
+		struct Probe
+		{
+			static constexpr int MaxEvents = 8;  // only the first events of large frames are sampled
+
+			Devices::DeviceHandle device {0};
+			uint8_t count {0};
+			Devices::EventType types[MaxEvents];
+			uint64_t steadyTimes[MaxEvents];
+			uint64_t dispatchTime {0};
+			uint64_t processedTime {0};
+
+			void addEvent(const Devices::EventRecord &ev) {
+				if (count < MaxEvents && ev.steadyTime) {
+					types[count] = ev.type;
+					steadyTimes[count++] = ev.steadyTime;
+				}
+			}
+		};
+
+		static LatencyStats *instance() {
+			static LatencyStats stats;
+			return &stats;
+		}
+
+		bool isEnabled() const { return m_enabled.load(std::memory_order_relaxed); }
+		void setEnabled(bool enabled) { m_enabled.store(enabled, std::memory_order_relaxed); }
+
+		// Records all the stage latencies of a probe; `writtenTime` is the time the probe reached the socket stage.
+		void record(const Probe &p, uint64_t writtenTime)
+		{
+			if (!p.count)
+				return;
+			stage(LS_Plugin).record(usec(p.dispatchTime, p.processedTime));
+			stage(LS_Socket).record(usec(p.processedTime, writtenTime));
+			LatencyHistogram *dev = device(p.device, true);
+			for (int i = 0; i < p.count; ++i) {
+				const uint64_t total = usec(p.steadyTimes[i], writtenTime);
+				stage(LS_Queue).record(usec(p.steadyTimes[i], p.dispatchTime));
+				stage(LS_Total).record(total);
+				eventType(p.types[i]).record(total);
+				if (dev)
+					dev->record(total);
+			}
+		}
+
+		LatencyHistogram &stage(Stage s) { return m_stages[s]; }
+		LatencyHistogram &eventType(Devices::EventType t) { return m_types[t]; }
+
+		// Returns the total latency histogram for a device, or null if none exists (and `create` is false) or the handle is out of range.
+		LatencyHistogram *device(Devices::DeviceHandle h, bool create = false)
+		{
+			if (!h || h >= MaxDevices)
+				return nullptr;
+			LatencyHistogram *hist = m_devices[h].load(std::memory_order_acquire);
+			if (hist || !create)
+				return hist;
+			LatencyHistogram *newHist = new LatencyHistogram();
+			if (m_devices[h].compare_exchange_strong(hist, newHist, std::memory_order_acq_rel))
+				return newHist;
+			delete newHist;
+			return hist;
+		}
+
+	private:
+		LatencyStats() = default;
+		~LatencyStats() {
+			for (auto &h : m_devices)
+				delete h.load();
+		}
+		Q_DISABLE_COPY(LatencyStats)
+
+		static uint64_t usec(uint64_t from, uint64_t to) { return to > from ? (to - from) / 1000 : 0; }
+
+		std::atomic_bool m_enabled { false };
+		std::array<LatencyHistogram, LS_ENUM_MAX> m_stages;
+		std::array<LatencyHistogram, Devices::EventType::EVENT_TYPE_ENUM_MAX> m_types;
+		std::array<std::atomic<LatencyHistogram *>, MaxDevices> m_devices {};
+};
@@ -29,7 +29,9 @@ to any 3rd-party components used within.
 // #include "DSE.h"
 #include "device/events.h"
 #include "DeviceManager.h"
+#include "FloatChars.h"
 #include "InputDevice.h"
+#include "LatencyStats.h"
 #include "Logger.h"
 #include "utils.h"
 #include "version.h"
@@ -37,6 +39,7 @@ to any 3rd-party components used within.
 
 #define SETTINGS_GROUP_PLUGIN             "Plugin"
 #define SETTINGS_GROUP_DEFAULT_DEVICES    "DefaultDevices"
+#define SETTINGS_GROUP_AXIS_CONDITIONING  "AxisConditioning"
 #define SETTINGS_KEY_VERSION              "SettingsVersion"
 
 using namespace Strings;
@@ -71,23 +74,30 @@ Q_GLOBAL_STATIC_WITH_ARGS(const ModKeyToStateIdMap, ModKeyToStateId, ({
 // Q_GLOBAL_STATIC(TimerDatahash, g_timersData)
 // Q_GLOBAL_STATIC(QReadWriteLock, g_timersDataMutex)
 
-struct EventFilter
+// Report filter rules for one event type, as parsed from the Device Filter action. Later ranges override earlier ones.
+struct EventFilterRules
 {
-	// QSet<int> include;
-	// QSet<int> exclude;
-	bool inclusive {false};
-	bool wildcard  {false};
-	QHash<int, bool> filters {};
+	struct Range {
+		uint16_t first;
+		uint16_t last;
+		bool include;
+	};
+	bool used      {false};
+	bool inclusive {false};  // unlisted controls are excluded
+	bool wildcard  {false};  // all controls of this type are excluded
+	QList<Range> ranges {};
 
-	friend QDebug operator <<(QDebug dbg, const EventFilter &obj) {
+	friend QDebug operator <<(QDebug dbg, const EventFilterRules &obj) {
 		QDebugStateSaver saver(dbg);
-		return dbg.nospace() << obj.inclusive << DBG_SEP << obj.wildcard << DBG_SEP << obj.filters;
+		dbg.nospace() << obj.inclusive << DBG_SEP << obj.wildcard;
+		for (const Range &r : obj.ranges)
+			dbg << DBG_SEP << (r.include ? "" : "!") << r.first << '-' << r.last;
+		return dbg;
 	}
 };
+using deviceEventFilterRules_t = std::array<EventFilterRules, EventType::EVENT_TYPE_ENUM_MAX>;
 
-using eventFilter_t = EventFilter; // QHash<int, bool>;  // control index, include/exclude
-using deviceEventFilter_t = QHash<EventType, eventFilter_t>;  // EventType to filter
-using eventFilters_t = QHash<QByteArray, deviceEventFilter_t>;         // Device uid to event type filter
+using eventFilters_t = std::vector<DeviceEventFilterPtr>;  // indexed by device handle; null if device has no filter
 Q_GLOBAL_STATIC(eventFilters_t, g_deviceEventFilters)
 
 bool g_startupComplete = false;
@@ -100,15 +110,15 @@ struct PluginSettings {
 	bool sendSpecificStates {true};
 	bool sendGenericStates {true};
 	bool sendEvents {true};
+	qint64 outputHighWatermark {256 * 1024};  // bytes pending to TP at which output switches to degraded mode; 0 to disable
+	qint64 outputLowWatermark {64 * 1024};    // bytes pending to TP at which degraded mode ends
+	int valuePrecision {-1};                  // decimal places of axis/position values in states and events; -1 for shortest exact value
 } g_settings;
 
 
-template <typename T>
-static T formatFloatNumber(float num) {
-	return T::number(num, 'f', QLocale::FloatingPointShortest);
-}
-static QByteArray formatFloatBA(float num) { return formatFloatNumber<QByteArray>(num); }
-static QString formatFloatStr(float num) { return formatFloatNumber<QString>(num); }
+static QByteArray formatFloatBA(float num) { return FloatChars(num).toByteArray(); }
+// Device event axis and position values, with the user's precision setting.
+static FloatChars formatEventValue(float num) { return FloatChars(num, g_settings.valuePrecision); }
 
 static inline DeviceManager *DMI() { return DeviceManager::instance(); }
 
@@ -131,6 +141,17 @@ Plugin::Plugin(const QString &tpHost, uint16_t tpPort, const QByteArray &pluginI
 	// loadPluginSettings();
 
 	client->setHostProperties(tpHost, tpPort);
+	client->setWriteWatermarks(g_settings.outputHighWatermark, g_settings.outputLowWatermark);
+	// skip sending state values which haven't changed; room for the states of many devices
+	client->setStateValueCacheSize(4096);
+	// only the message types handled in onTpMessage() are parsed, the rest are dropped unread
+	client->setMessageTypeFilter({
+		TPClientQt::MessageType::action,
+		TPClientQt::MessageType::down,
+		TPClientQt::MessageType::broadcast,
+		TPClientQt::MessageType::settings,
+		TPClientQt::MessageType::closePlugin,
+	});
 
 	// Set up constant IDs of things we send to TP like states and choice list updates.
 	for (int i = 0; i < SID_ENUM_MAX; ++i)
@@ -148,10 +169,12 @@ Plugin::Plugin(const QString &tpHost, uint16_t tpPort, const QByteArray &pluginI
 	connect(client, &TPClientQt::disconnected, this, &Plugin::onClientDisconnect);
 	connect(client, &TPClientQt::error, this, &Plugin::onClientError);
 	connect(client, &TPClientQt::message, this, &Plugin::onTpMessage);
+	connect(client, &TPClientQt::highWatermark, this, &Plugin::onOutputHighWatermark);
+	connect(client, &TPClientQt::lowWatermark, this, &Plugin::onOutputLowWatermark);
 
 	connect(this, &Plugin::tpConnect, client, qOverload<>(&TPClientQt::connect));
 	//connect(this, &Plugin::tpDisconnect, client, &TPClientQt::disconnect, Qt::DirectConnection);
-	connect(this, &Plugin::tpStateUpdate, client, qOverload<const QByteArray &, const QByteArray &>(&TPClientQt::stateUpdate));
+	connect(this, &Plugin::tpStateUpdate, client, qOverload<const QByteArray &, const QByteArray &, bool>(&TPClientQt::stateUpdate));
 	// connect(this, &Plugin::tpStateUpdateStr, client, qOverload<const QByteArray &, QStringView>(&TPClientQt::stateUpdate));
 	connect(this, &Plugin::tpStateCreate, client, qOverload<const QByteArray &, const QByteArray &, const QByteArray &, const QByteArray &, bool>(&TPClientQt::createState));
 	// connect(this, &Plugin::tpStateRemove, client, qOverload<const QByteArray &>(&TPClientQt::removeState));
@@ -160,6 +183,7 @@ Plugin::Plugin(const QString &tpHost, uint16_t tpPort, const QByteArray &pluginI
 	// connect(this, &Plugin::tpChoiceUpdate, client, qOverload<const QByteArray &, const QByteArrayList &>(&TPClientQt::choiceUpdate));
 	// connect(this, &Plugin::tpChoiceUpdateInstance, client, qOverload<const QByteArray &, const QByteArray &, const QByteArrayList &>(&TPClientQt::choiceUpdate));
 	connect(this, &Plugin::tpTriggerEvent, client, qOverload<const QByteArray &, const QJsonObject &>(&TPClientQt::triggerEvent));
+	connect(this, &Plugin::tpWrite, client, &TPClientQt::write);
 	// connect(this, &Plugin::tpConnectorUpdateShort, client, qOverload<const QByteArray&, uint8_t>(&TPClientQt::connectorUpdate));
 	connect(this, &Plugin::tpSettingUpdate, client, qOverload<const QByteArray&, const QByteArray &>(&TPClientQt::settingUpdate));
 	// connect(this, &Plugin::tpNotification, client, qOverload<const QByteArray&, const QByteArray&, const QByteArray&, const QVariantList&>(&TPClientQt::showNotification));
@@ -170,7 +194,7 @@ Plugin::Plugin(const QString &tpHost, uint16_t tpPort, const QByteArray &pluginI
 	connect(dm, &DeviceManager::deviceNameChanged, this, &Plugin::onDeviceNameChanged);
 	connect(dm, &DeviceManager::deviceStateChanged, this, &Plugin::onDeviceStateChanged);
 	// connect(dm, &DeviceManager::deviceEvent, this, &Plugin::onDeviceEvent /*, Qt::QueuedConnection*/);
-	connect(dm, &DeviceManager::deviceEventPtr, this, &Plugin::onDeviceEventPtr , Qt::QueuedConnection);
+	connect(dm, &DeviceManager::deviceEventBatch, this, &Plugin::onDeviceEventBatch, Qt::DirectConnection);
 	connect(dm, &DeviceManager::displayDetected, this, &Plugin::updateDisplayInfoStates /*, Qt::QueuedConnection*/);
 	connect(dm, &DeviceManager::displayRemoved, this, &Plugin::removeDisplayStates /*, Qt::QueuedConnection*/);
 
@@ -183,6 +207,16 @@ Plugin::Plugin(const QString &tpHost, uint16_t tpPort, const QByteArray &pluginI
 	m_deviceListTmr.setInterval(750);
 	connect(&m_deviceListTmr, &QTimer::timeout, this, &Plugin::sendInstanceLists);
 
+	connect(&m_latencyTmr, &QTimer::timeout, this, &Plugin::reportLatencyStats);
+
+	m_rateLimitTmr.setTimerType(Qt::PreciseTimer);
+	m_rateLimitTmr.setInterval(RateLimiter::TickMs);
+	connect(&m_rateLimitTmr, &QTimer::timeout, this, &Plugin::flushRateLimited);
+
+	// time for TP to process each new state
+	m_stateCreateTmr.setInterval(2);
+	connect(&m_stateCreateTmr, &QTimer::timeout, this, &Plugin::sendNextQueuedState);
+
 	Q_EMIT tpConnect();
 	//QMetaObject::invokeMethod(this, "start", Qt::QueuedConnection);
 }
@@ -247,6 +281,7 @@ void Plugin::init()
 {
 	DeviceManager::instance()->init();
 	loadDefaultDevices();
+	loadAxisConditioning();
 	updatePluginState(AT_Started);
 	g_startupComplete = true;
 }
@@ -282,13 +317,106 @@ void Plugin::saveDefaultDevices() const
 	s.endGroup();
 }
 
-void Plugin::createStateWithDelay(const QByteArray &stateId, const QByteArray &parent, const QByteArray &name, const QByteArray &dflt, bool force, int delayMs) const
+void Plugin::loadAxisConditioning()
+{
+	m_axisConditioning.clear();
+
+	QSettings s;
+	const int count = s.beginReadArray(SETTINGS_GROUP_AXIS_CONDITIONING);
+	for (int i = 0; i < count; ++i) {
+		s.setArrayIndex(i);
+		const QString devName = s.value("device").toString();
+		const AxisConditioning cfg = AxisConditioning {
+			s.value("center").toFloat(),
+			s.value("edge").toFloat(),
+			s.value("hysteresis").toFloat(),
+			(uint16_t)s.value("steps").toUInt()
+		}.bounded();
+		if (!devName.isEmpty() && !cfg.isNull())
+			m_axisConditioning[devName].insert(s.value("axis").toUInt(), cfg);
+	}
+	s.endArray();
+	qCDebug(lcPlugin) << "Loaded axis conditioning settings for" << m_axisConditioning.size() << "device(s).";
+}
+
+void Plugin::saveAxisConditioning() const
 {
-	Q_EMIT tpStateCreate(stateId, parent, /*STATE_NAME_PREFIX ": " +*/ name, dflt, force);
-	// time for TP to process new state
-	if (delayMs)
-		QThread::msleep(delayMs);
-	// Utils::waitMs(2);
+	QSettings s;
+	s.remove(SETTINGS_GROUP_AXIS_CONDITIONING);
+	s.beginWriteArray(SETTINGS_GROUP_AXIS_CONDITIONING);
+	int i = 0;
+	for (const auto &[devName, axes] : m_axisConditioning.asKeyValueRange()) {
+		for (const auto &[axis, cfg] : axes.asKeyValueRange()) {
+			s.setArrayIndex(i++);
+			s.setValue("device", devName);
+			s.setValue("axis", axis);
+			s.setValue("center", cfg.centerDeadzone);
+			s.setValue("edge", cfg.edgeDeadzone);
+			s.setValue("hysteresis", cfg.hysteresis);
+			s.setValue("steps", cfg.steps);
+		}
+	}
+	s.endArray();
+}
+
+void Plugin::applyAxisConditioning(const InputDevice *dev) const
+{
+	if (!dev || !dev->type().testFlag(DeviceType::DT_Controller))
+		return;
+	DMI()->clearAxisConditioning(dev->uid());
+	const auto it = m_axisConditioning.constFind(dev->name());
+	if (it == m_axisConditioning.cend())
+		return;
+	for (const auto &[axis, cfg] : it->asKeyValueRange())
+		DMI()->setAxisConditioning(dev->uid(), axis, cfg);
+	qCDebug(lcPlugin) << "Applied axis conditioning for" << it->size() << "axis setting(s) to device" << dev->name();
+}
+
+// Queues a state to be created. TP needs some time to process each new state before it can be updated, so the create messages are
+// paced with a timer instead of blocking the caller. Updates to a state which is still queued are saved as its default value.
+void Plugin::createState(const QByteArray &stateId, const QByteArray &parent, const QByteArray &name, const QByteArray &dflt, bool force)
+{
+	if (const auto it = m_pendingStates.find(stateId); it != m_pendingStates.end()) {
+		if (!it->sent) {
+			it->parent = parent;
+			it->name = name;
+			it->force = it->force || force;
+		}
+		return;
+	}
+	m_pendingStates.insert(stateId, { parent, name, dflt, force });
+	m_stateCreateQueue.append(stateId);
+	if (!m_stateCreateTmr.isActive())
+		m_stateCreateTmr.start();
+}
+
+// Sends a state update, or holds it until the state has been created if that is still pending.
+void Plugin::updateState(const QByteArray &stateId, const QByteArray &value)
+{
+	if (const auto it = m_pendingStates.find(stateId); it != m_pendingStates.end()) {
+		it->value = value;
+		it->updated = it->sent;
+		return;
+	}
+	Q_EMIT tpStateUpdate(stateId, value);
+}
+
+void Plugin::sendNextQueuedState()
+{
+	if (!m_lastCreatedState.isEmpty()) {
+		const PendingState ps = m_pendingStates.take(m_lastCreatedState);
+		if (ps.updated)
+			Q_EMIT tpStateUpdate(m_lastCreatedState, ps.value);
+		m_lastCreatedState.clear();
+	}
+	if (m_stateCreateQueue.isEmpty()) {
+		m_stateCreateTmr.stop();
+		return;
+	}
+	m_lastCreatedState = m_stateCreateQueue.takeFirst();
+	PendingState &ps = m_pendingStates[m_lastCreatedState];
+	ps.sent = true;
+	Q_EMIT tpStateCreate(m_lastCreatedState, ps.parent, /*STATE_NAME_PREFIX ": " +*/ ps.name, ps.value, ps.force);
 }
 
 void Plugin::updatePluginState(ActionTokens state, bool direct) const
@@ -323,11 +451,10 @@ void Plugin::updateDisplayInfoStates(const DisplayInfo &si)
 	const auto updateSiField = [this, &indexName, &fullName](const QByteArray &field, const QString &fieldName, const QByteArray &value)
 	{
 		const QByteArray stateId = m_pluginStateIdPrefix + PLUGIN_STR_STATEID_DISPLAY PLUGIN_STR_PATH_SEP + indexName + g_pathSep + field;
-		QWriteLocker lock(&m_mtxDeviceStates);
-		if (m_deviceStates[DI_SYSTEM_SCREEN_UID][stateId].isNull())
-			createStateWithDelay(stateId, fullName, fullName + " - "_ba + fieldName.toUtf8(), "", true);
-		m_deviceStates[DI_SYSTEM_SCREEN_UID][stateId] = value;
-		Q_EMIT tpStateUpdate(stateId, value);
+		if (!m_displayStates.contains(stateId))
+			createState(stateId, fullName, fullName + " - "_ba + fieldName.toUtf8(), "", true);
+		m_displayStates[stateId] = value;
+		updateState(stateId, value);
 	};
 
 	updateSiField("name"_ba, tr("Name"),             name);
@@ -346,18 +473,17 @@ void Plugin::updateDisplayInfoStates(const DisplayInfo &si)
 	if ((ushort)si.index > g_systemDisplaysCount) {
 		g_systemDisplaysCount = (ushort)si.index;
 		QByteArray *stateId = &m_stateIds[SID_DisplaysCount];
-		QWriteLocker lock(&m_mtxDeviceStates);
-		if (m_deviceStates[DI_SYSTEM_SCREEN_UID].value(*stateId).isNull())
-			createStateWithDelay(*stateId, PLUGIN_STR_CAT_DEVICES_NAME, tr("Display Count").toUtf8(), BoolStr[0], true);
-		m_deviceStates[DI_SYSTEM_SCREEN_UID][*stateId] = indexName;
-		Q_EMIT tpStateUpdate(*stateId, indexName);
+		if (!m_displayStates.contains(*stateId))
+			createState(*stateId, PLUGIN_STR_CAT_DEVICES_NAME, tr("Display Count").toUtf8(), BoolStr[0], true);
+		m_displayStates[*stateId] = indexName;
+		updateState(*stateId, indexName);
 
 		if (si.isPrimary) {
 			stateId = &m_stateIds[SID_DisplayPrimary];
-			if (m_deviceStates[DI_SYSTEM_SCREEN_UID].value(*stateId).isNull())
-				createStateWithDelay(*stateId, PLUGIN_STR_CAT_DEVICES_NAME, tr("Primary Display").toUtf8(), BoolStr[0], true);
-			m_deviceStates[DI_SYSTEM_SCREEN_UID][*stateId] = indexName;
-			Q_EMIT tpStateUpdate(*stateId, indexName);
+			if (!m_displayStates.contains(*stateId))
+				createState(*stateId, PLUGIN_STR_CAT_DEVICES_NAME, tr("Primary Display").toUtf8(), BoolStr[0], true);
+			m_displayStates[*stateId] = indexName;
+			updateState(*stateId, indexName);
 		}
 	}
 }
@@ -370,15 +496,14 @@ void Plugin::removeDisplayStates(short nDisplay)
 	{
 		const QByteArray stateId = m_pluginStateIdPrefix + PLUGIN_STR_CAT_DEVICES_NAME PLUGIN_STR_PATH_SEP + indexName + g_pathSep + field;
 		Q_EMIT tpStateRemove(stateId);
-		QWriteLocker lock(&m_mtxDeviceStates);
-		m_deviceStates.remove(stateId);
+		m_displayStates.remove(stateId);
 	};
 	for (const auto &field : { "name"_ba, "x"_ba, "y"_ba, "w"_ba, "h"_ba, "primary"_ba, "scaling"_ba })
 		removeSiField(field);
 }
 
 // Keyboard common modifier states setup, used when keyboard report starts
-void Plugin::setupKeyboardStates(const InputDevice *dev) const
+void Plugin::setupKeyboardStates(const InputDevice *dev)
 {
 	static const QHash<uint8_t, QString> modifierNames {
 		{ StateIdToken::SID_KbdModShift,   tr("Modifier - SHIFT") },
@@ -403,16 +528,37 @@ void Plugin::setupKeyboardStates(const InputDevice *dev) const
 	for (uint8_t i = StateIdToken::SID_KBDMOD_FIRST; i <= StateIdToken::SID_KBDMOD_LAST; ++i){
 		// const QByteArray fullStateId = m_stateIds[i]; // + stateNameForDevice(dev) + g_pathSep + stateId;
 		if (const auto &modName = modifierNames.value(i); !modName.isEmpty()) {
-			const QString stateName = dev->name() + " - " + modName;
-			createStateWithDelay(m_stateIds[i], dev->name().toUtf8(), (dev->name() + " - " + modName).toUtf8(), BoolStr[0], true, 0);
+			createState(m_stateIds[i], dev->name().toUtf8(), (dev->name() + " - " + modName).toUtf8(), BoolStr[0], true);
 		}
 	}
-	// Utils::waitMs(1);
-	QThread::msleep(1);
 	// update the toggle keys
 	DMI()->requestDeviceReport(dev->uid());
 }
 
+// Queues creation of states for all of a controller's axes, hats and buttons when its report starts, so that they're
+// (most likely) ready by the time any input arrives.
+void Plugin::setupControllerStates(const InputDevice *dev)
+{
+	if (!(outputSinks(dev) & OS_States))
+		return;
+	const ControlCounts counts = dev->controlCounts();
+	const auto tbl = m_stateIdTables.find(dev->handle());
+	DeviceStateIdTable &table = tbl != m_stateIdTables.end() ? tbl.value() : buildStateIdTable(dev);
+	const auto setupStates = [&](EventType type, uint16_t count) {
+		// control indexes in events are 1-based
+		for (uint16_t i = 1; i <= count; ++i) {
+			ControlStateIds &ids = controlStateIds(table, dev, type, i);
+			if (!ids.created) {
+				createState(ids.fullStateId, table.device.name, ids.name);
+				ids.created = true;
+			}
+		}
+	};
+	setupStates(EventType::Event_Axis, counts.axes);
+	setupStates(EventType::Event_Hat, counts.hats);
+	setupStates(EventType::Event_Button, counts.buttons);
+}
+
 //
 
 static QByteArray makeCleanStateId(const QString &dev) {
@@ -510,6 +656,7 @@ void Plugin::sendInstanceLists() const
 
 	Q_EMIT tpChoiceUpdate(m_choiceListIds[CLID_DeviceFilterDevName], nameArry);
 	Q_EMIT tpChoiceUpdate(m_choiceListIds[CLID_DeviceCtrDevName], nameArry);
+	Q_EMIT tpChoiceUpdate(m_choiceListIds[CLID_AxisCondDevName], nameArry);
 
 	// qCDebug(lcPlugin) << "Sent list updates" << m_stateIds[SID_DevicesList] << nameArry.join('\n');
 }
@@ -544,7 +691,7 @@ void Plugin::sendDefaultAssignedDeviceStateUpdate(Devices::DeviceTypes devType)
 		Q_EMIT tpStateUpdate(stateId, deviceName.toUtf8());
 }
 
-void Plugin::sendFullStatusReport() const
+void Plugin::sendFullStatusReport()
 {
 	DeviceManager *dm = DeviceManager::instance();
 	updatePluginState(ActionTokens::AT_Started, false);
@@ -555,8 +702,6 @@ void Plugin::sendFullStatusReport() const
 		if (dev->state() == DeviceState::DS_Reporting) {
 			onDeviceReportStarted(dev);
 			dm->requestDeviceReport(dev->uid());
-			QThread::msleep(1);
-			// Utils::waitMs(1);
 		}
 		else {
 			onDeviceReportStopped(dev);
@@ -621,12 +766,12 @@ static const QByteArray deviceLocalStatePrefix(const QByteArray &act, const QByt
 }
 
 // Common local states object for all device input events
-static QJsonObject deviceStatesObject(const InputDevice * const dev, const QByteArray &act)
+static QJsonObject deviceStatesObject(const DevicePresentation &dev, const QByteArray &act)
 {
 	return QJsonObject({
-		{ deviceLocalStatePrefix(act, "device.name"_ba),   dev->name() },
-		{ deviceLocalStatePrefix(act, "device.type"_ba),   Devices::deviceTypeName(dev->type()) },
-		{ deviceLocalStatePrefix(act, "device.typeId"_ba), QString::number(dev->type()) },
+		{ deviceLocalStatePrefix(act, "device.name"_ba),   QString::fromUtf8(dev.name) },
+		{ deviceLocalStatePrefix(act, "device.type"_ba),   QString::fromUtf8(dev.typeName) },
+		{ deviceLocalStatePrefix(act, "device.typeId"_ba), QLatin1StringView(dev.typeId) },
 	});
 }
 
@@ -642,11 +787,12 @@ void Plugin::dispatchDeviceEvent(const InputDevice *dev, ActionTokens event, Sta
 	if (stateId != StateIdToken::SID_ENUM_MAX)
 		Q_EMIT tpStateUpdate(m_stateIds[stateId], formatDeviceAndTypeName(dev).toUtf8());
 
-	// triggers deviceStatusChange event
-	Q_EMIT tpStateUpdate(m_stateIds[SID_DeviceStatusChange], g_actionTokenStrings[event]);
+	// triggers deviceStatusChange event, so it is sent even if the status is the same as the last device's
+	Q_EMIT tpStateUpdate(m_stateIds[SID_DeviceStatusChange], g_actionTokenStrings[event], true);
 
 	static const QByteArray evName; // "DeviceEvent"_ba;
-	QJsonObject evStates = deviceStatesObject(dev, evName);
+	const auto ids = m_stateIdTables.constFind(dev->handle());
+	QJsonObject evStates = deviceStatesObject(ids != m_stateIdTables.cend() ? ids->device : devicePresentation(dev), evName);
 	evStates.insert(deviceLocalStatePrefix(evName, "device.status"_ba), g_actionTokenStrings[event]);
 	Q_EMIT tpTriggerEvent(m_eventIds[EID_DeviceEvent], evStates);
 
@@ -654,32 +800,38 @@ void Plugin::dispatchDeviceEvent(const InputDevice *dev, ActionTokens event, Sta
 	// 	Q_EMIT tpTriggerEvent(m_eventIds[eventId], deviceStatesObject(dev, g_actionTokenStrings[event]));
 }
 
-void Plugin::onDeviceConnected(const QByteArray &uid) const
+void Plugin::onDeviceConnected(const QByteArray &uid)
 {
 	if (InputDevice *dev = DMI()->device(uid)) {
 		// sendInstanceLists();
+		buildStateIdTable(dev);
+		applyAxisConditioning(dev);
 		dispatchDeviceEvent(dev, AT_Found, SID_LastFoundDevice /*, EID_DeviceFound*/);
 		return;
 	}
 	qCWarning(lcPlugin) << "Couldn't get device for" << uid;
 }
 
-void Plugin::onDeviceRemoved(const QByteArray &uid) const
+void Plugin::onDeviceRemoved(const QByteArray &uid)
 {
 	if (InputDevice *dev = DMI()->device(uid)) {
 		// sendInstanceLists();
+		m_stateIdTables.remove(dev->handle());
+		m_rateLimiter.removeDevice(dev->handle());
 		dispatchDeviceEvent(dev, AT_Removed, SID_LastRemovedDevice /*, EID_DeviceRemoved*/);
 		return;
 	}
 	qCWarning(lcPlugin) << "Couldn't get device for" << uid;
 }
 
-void Plugin::onDeviceReportStarted(const InputDevice *dev) const
+void Plugin::onDeviceReportStarted(const InputDevice *dev)
 {
 	dispatchDeviceEvent(dev, ActionTokens::AT_Started, SID_DevReportStarted /*, EID_ReportStarted*/);
 
 	if (dev->type().testFlag(DeviceType::DT_Keyboard))
 		setupKeyboardStates(dev);
+	else if (dev->type().testFlag(DeviceType::DT_Controller))
+		setupControllerStates(dev);
 }
 
 void Plugin::onDeviceReportStopped(const InputDevice *dev) const
@@ -702,8 +854,15 @@ void Plugin::onDeviceStateChanged(const InputDevice *dev, DeviceState newState,
 	Q_EMIT tpStateUpdate(m_stateIds[SID_ReportingDevices], formatDeviceNamesList(DeviceState::DS_Reporting));
 }
 
-void Plugin::onDeviceNameChanged(const InputDevice *dev, const QString &/*name*/) const
+void Plugin::onDeviceNameChanged(const InputDevice *dev, const QString &/*name*/)
 {
+	// State IDs include the device name, so any prebuilt ones are now invalid and the states need to be created again.
+	if (dev && m_stateIdTables.contains(dev->handle())) {
+		buildStateIdTable(dev);
+		m_controlStates.clear(dev->handle());
+		m_rateLimiter.removeDevice(dev->handle());
+	}
+	applyAxisConditioning(dev);
 	if (dev && dev->state() > DeviceState::DS_Seen /*&& !m_deviceListTmr.isActive()*/) {
 		sendInstanceLists();
 		sendDeviceInstanceUpdates(dev);
@@ -711,164 +870,355 @@ void Plugin::onDeviceNameChanged(const InputDevice *dev, const QString &/*name*/
 	}
 }
 
-void Plugin::onDeviceEvent(const DeviceEvent &ev)
+// Data which is common to all events in one device update frame.
+struct DeviceEventFrame
+{
+	const InputDevice * const dev;
+	const DeviceEventFilter * const filter;    // null if device has no filter
+	Plugin::DeviceStateIdTable &ids;           // prebuilt state IDs for this device
+};
+
+// Returns the outputs enabled for a device's events, which are those enabled in settings and not turned off for the specific device.
+uint8_t Plugin::outputSinks(const InputDevice *dev) const
+{
+	const uint8_t sinks = (g_settings.sendSpecificStates ? OS_States : OS_None) | (g_settings.sendEvents ? OS_Events : OS_None);
+	return dev->handle() < m_deviceSinks.size() ? sinks & m_deviceSinks[dev->handle()] : sinks;
+}
+
+void Plugin::setDeviceSinks(const InputDevice *dev, uint8_t sinks)
+{
+	if (dev->handle() >= m_deviceSinks.size())
+		m_deviceSinks.resize(dev->handle() + 1, OS_All);
+	m_deviceSinks[dev->handle()] = sinks;
+	// pre-create states which were skipped while they were turned off
+	if ((sinks & OS_States) && dev->state() == DeviceState::DS_Reporting && dev->type().testFlag(DeviceType::DT_Controller))
+		setupControllerStates(dev);
+}
+
+void Plugin::onDeviceEventBatch(const InputDevice *dev, std::span<const EventRecord> events)
 {
-	if (!g_settings.sendEvents && !g_settings.sendSpecificStates /*&& !g_settings.sendGenericStates*/)
+	if (!dev || events.empty() /*|| dev->state() != DeviceState::DS_Reporting*/)
 		return;
 
-	const InputDevice *dev = ev.device ? ev.device : DMI()->device(ev.deviceUid);
-	if (!dev /*|| dev->state() != DeviceState::DS_Reporting*/)
+	using EventHandler = void (Plugin::*)(DeviceEventFrame &, const EventRecord &);
+	static constexpr EventHandler handlers[OS_All + 1] {
+		nullptr,
+		&Plugin::handleDeviceEvent<true, false>,
+		&Plugin::handleDeviceEvent<false, true>,
+		&Plugin::handleDeviceEvent<true, true>,
+	};
+	const EventHandler handler = handlers[outputSinks(dev)];
+	if (!handler)
 		return;
 
-	const auto &idf = g_deviceEventFilters->find(dev->uid());
-	if (idf != g_deviceEventFilters->cend()) {
-		const auto &ief = idf->find(ev.type);
-		if (ief != idf->cend()) {
-			const EventFilter &ef = ief.value();
-			if (ef.wildcard)
-				return;
-			const auto &cef = ef.filters.find(ev.index);
-			if (cef != ef.filters.cend()) {
-				if (!cef.value())
-					return;
-			}
-			else if (ef.inclusive) {
-				return;
-			}
+	const auto ids = m_stateIdTables.find(dev->handle());
+	DeviceEventFrame frame {
+		dev,
+		dev->handle() < g_deviceEventFilters->size() ? (*g_deviceEventFilters)[dev->handle()].get() : nullptr,
+		ids != m_stateIdTables.end() ? ids.value() : buildStateIdTable(dev),
+	};
+
+	LatencyStats *latency = LatencyStats::instance();
+	LatencyStats::Probe probe;
+	const bool measure = latency->isEnabled();
+	if (measure) {
+		probe.device = events.front().device;
+		probe.dispatchTime = steadyClockNs();
+	}
+
+	for (const EventRecord &ev : events) {
+		if (!frame.filter || frame.filter->passes(ev)) {
+			(this->*handler)(frame, ev);
+			if (measure && !ev.isFrameMarker())
+				probe.addEvent(ev);
 		}
 	}
 
-	QByteArray stateValue;
-	EventIdToken evId = EID_ENUM_MAX;
-	QByteArray ctrlName(QByteArray::number(ev.index));
+	// The probe is queued to the client thread after any state/event messages sent above; it flushes those to the socket first
+	// so the measurement includes the write instead of stopping while they're still waiting to be coalesced.
+	if (measure && probe.count) {
+		probe.processedTime = steadyClockNs();
+		QMetaObject::invokeMethod(client, [c = client, latency, probe]() {
+			c->flush();
+			latency->record(probe, steadyClockNs());
+		}, Qt::QueuedConnection);
+	}
+}
+
+DevicePresentation Plugin::devicePresentation(const InputDevice *dev)
+{
+	return DevicePresentation {
+		dev->name().toUtf8(),
+		makeCleanStateId(dev->name()),
+		Devices::deviceTypeName(dev->type()).toUtf8(),
+		QByteArray::number(dev->type().toInt()),
+	};
+}
+
+Plugin::DeviceStateIdTable &Plugin::buildStateIdTable(const InputDevice *dev)
+{
+	DeviceStateIdTable &table = m_stateIdTables[dev->handle()];
+	table = DeviceStateIdTable { devicePresentation(dev) };
+	table.stateIdPrefix = m_pluginStateIdPrefix + table.device.stateName + g_pathSep;
+	return table;
+}
+
+// `keyName` is required for key events, which use the key name instead of index in state IDs.
+Plugin::ControlStateIds &Plugin::controlStateIds(DeviceStateIdTable &table, const InputDevice *dev, EventType type, uint16_t index, const char *keyName)
+{
+	std::vector<ControlStateIds> &controls = table.controls[type];
+	if (index >= controls.size())
+		controls.resize(index + 1);
+	ControlStateIds &ids = controls[index];
+	if (!ids.stateId.isEmpty())
+		return ids;
+
+	QByteArray ctrlName = keyName ? QByteArray(keyName) : QByteArray::number(index);
+	ids.stateId = QByteArray(g_deviceEventStateIds[type]) + g_pathSep + ctrlName;
+	ids.fullStateId = table.stateIdPrefix + ids.stateId;
+	// pad button names to 3 digits on controllers so states sort alphabetically
+	if (type == EventType::Event_Button && dev->type().testFlag(DeviceType::DT_Controller)) {
+		while (ctrlName.size() < 3)
+			ctrlName.prepend('0');
+	}
+	ids.name = table.device.name + " - " + g_deviceEventStrings[type] + ' ' + ctrlName;
+	return ids;
+}
+
+// Returns the pre-serialized trigger event message template for a device and event type, building it the first time it's needed,
+// or null if the event type isn't sent as a TP event. The order of value states is the order the values are passed to build().
+const JsonMessageTemplate *Plugin::deviceEventTemplate(DeviceStateIdTable &table, const InputDevice *dev, EventType type) const
+{
+	JsonMessageTemplate &tpl = table.eventTemplates[type];
+	if (!tpl.isNull())
+		return &tpl;
+
+	EventIdToken evId;
+	QByteArrayList valueStates;
+	switch (type) {
+		case EventType::Event_Axis:
+			evId = EventIdToken::EID_DeviceAxis;
+			valueStates = { "index"_ba, "value"_ba };
+			break;
+		case EventType::Event_Button:
+			evId = EventIdToken::EID_DeviceButton;
+			valueStates = { "index"_ba, "state"_ba, "x"_ba, "y"_ba };
+			break;
+		case EventType::Event_Hat:
+			evId = EventIdToken::EID_DeviceHat;
+			valueStates = { "index"_ba, "value"_ba };
+			break;
+		case EventType::Event_Scroll:
+			evId = EventIdToken::EID_DeviceScroll;
+			valueStates = { "index"_ba, "x"_ba, "y"_ba, "relX"_ba, "relY"_ba };
+			break;
+		case EventType::Event_Motion:
+			evId = EventIdToken::EID_DeviceMotion;
+			valueStates = { "index"_ba, "x"_ba, "y"_ba, "relX"_ba, "relY"_ba };
+			// "buttons"
+			break;
+		case EventType::Event_Key:
+			evId = EventIdToken::EID_DeviceKey;
+			valueStates = { "key"_ba, "name"_ba, "text"_ba, "down"_ba, "repeat"_ba, "nativeKey"_ba };
+			// "mod", "nativeCode", "sdlKey"
+			break;
+		default:
+			return nullptr;
+	}
+
 	//const auto evName = (QByteArray(QMetaEnum::fromType<Devices::EventType>().valueToKey(ev.type) + 6) + "Event"_L1).toLatin1();
-	const QByteArray evName = g_deviceEventStrings[ev.type] + "Event"_ba;
-	QJsonObject evStates = deviceStatesObject(dev, evName);
+	const QByteArray evName = g_deviceEventStrings[type] + "Event"_ba;
+	for (QByteArray &st : valueStates)
+		st = deviceLocalStatePrefix(evName, st);
+	// same constant states as deviceStatesObject()
+	tpl = JsonMessageTemplate(m_eventIds[evId], {
+		{ deviceLocalStatePrefix(evName, "device.name"_ba),   table.device.name },
+		{ deviceLocalStatePrefix(evName, "device.type"_ba),   table.device.typeName },
+		{ deviceLocalStatePrefix(evName, "device.typeId"_ba), table.device.typeId },
+	}, valueStates);
+	return &tpl;
+}
+
+// The enabled outputs are template parameters so each combination compiles to a handler which does no work at all for disabled outputs.
+template <bool ToStates, bool ToEvents>
+void Plugin::handleDeviceEvent(DeviceEventFrame &frame, const EventRecord &ev)
+{
+	const InputDevice *dev = frame.dev;
+	QByteArray stateValue;
+	QByteArray evMessage;
+	// pre-serialized event message for this device and event type, with slots for the variable values
+	const JsonMessageTemplate *evTemplate = ToEvents ? deviceEventTemplate(frame.ids, dev, ev.type) : nullptr;
+	const QByteArray ctrlName = ToEvents ? QByteArray::number(ev.index) : QByteArray();
 
 	switch (ev.type)
 	{
 		case EventType::Event_Axis: {
-			const auto &aev = static_cast<const DeviceAxisEvent&>(ev);
-			stateValue = formatFloatBA(aev.value);
-			evId = EventIdToken::EID_DeviceAxis;
-			evStates.insert(deviceLocalStatePrefix(evName, "index"_ba), ctrlName.constData());
-			evStates.insert(deviceLocalStatePrefix(evName, "value"_ba), stateValue.constData());
+			const FloatChars value = formatEventValue(ev.axis.value);
+			if constexpr (ToStates)
+				stateValue = value.toByteArray();
+			if (evTemplate)
+				evMessage = evTemplate->build({ ctrlName, value });
 			break;
 		}
 		case EventType::Event_Button: {
-			const auto &aev = static_cast<const DeviceButtonEvent&>(ev);
+			const auto &aev = ev.button;
 			stateValue = BoolStr[aev.down];
-			evId = EventIdToken::EID_DeviceButton;
-			evStates.insert(deviceLocalStatePrefix(evName, "index"_ba), ctrlName.constData());
-			evStates.insert(deviceLocalStatePrefix(evName, "state"_ba), stateValue.constData());
-			evStates.insert(deviceLocalStatePrefix(evName, "x"_ba), formatFloatStr(aev.x));
-			evStates.insert(deviceLocalStatePrefix(evName, "y"_ba), formatFloatStr(aev.y));
-			// qCDebug(lcPlugin) << "Button Event" << aev.index << aev.down << aev.timestamp;
+			if (evTemplate)
+				evMessage = evTemplate->build({ ctrlName, stateValue, formatEventValue(aev.x), formatEventValue(aev.y) });
+			// qCDebug(lcPlugin) << "Button Event" << ev.index << aev.down << ev.timestamp;
 			break;
 		}
 		case EventType::Event_Hat: {
-			const auto &aev = static_cast<const DeviceHatEvent&>(ev);
-			stateValue = QByteArray::number(aev.value);
-			evId = EventIdToken::EID_DeviceHat;
-			evStates.insert(deviceLocalStatePrefix(evName, "index"_ba), ctrlName.constData());
-			evStates.insert(deviceLocalStatePrefix(evName, "value"_ba), stateValue.constData());
+			stateValue = QByteArray::number(ev.hat.value);
+			if (evTemplate)
+				evMessage = evTemplate->build({ ctrlName, stateValue });
 			break;
 		}
 		case EventType::Event_Scroll: {
-			const auto &aev = static_cast<const DeviceScrollEvent&>(ev);
-			stateValue = formatFloatBA(aev.relX) + ',' + formatFloatBA(aev.relY);
-			evId = EventIdToken::EID_DeviceScroll;
-			evStates.insert(deviceLocalStatePrefix(evName, "index"_ba), ctrlName.constData());
-			evStates.insert(deviceLocalStatePrefix(evName, "x"_ba), formatFloatStr(aev.x));
-			evStates.insert(deviceLocalStatePrefix(evName, "y"_ba), formatFloatStr(aev.y));
-			evStates.insert(deviceLocalStatePrefix(evName, "relX"_ba), formatFloatStr(aev.relX));
-			evStates.insert(deviceLocalStatePrefix(evName, "relY"_ba), formatFloatStr(aev.relY));
+			const auto &aev = ev.scroll;
+			const FloatChars relX = formatEventValue(aev.relX), relY = formatEventValue(aev.relY);
+			if constexpr (ToStates)
+				stateValue = relX.toByteArray().append(',').append(relY.view());
+			if (evTemplate)
+				evMessage = evTemplate->build({ ctrlName, formatEventValue(aev.x), formatEventValue(aev.y), relX, relY });
 			break;
 		}
 		case EventType::Event_Motion: {
-			const auto &aev = static_cast<const DeviceMotionEvent&>(ev);
-			stateValue = formatFloatBA(aev.x) + ',' + formatFloatBA(aev.y);
-			evId = EventIdToken::EID_DeviceMotion;
-			evStates.insert(deviceLocalStatePrefix(evName, "index"_ba), ctrlName.constData());
-			evStates.insert(deviceLocalStatePrefix(evName, "x"_ba), formatFloatStr(aev.x));
-			evStates.insert(deviceLocalStatePrefix(evName, "y"_ba), formatFloatStr(aev.y));
-			evStates.insert(deviceLocalStatePrefix(evName, "relX"_ba), formatFloatStr(aev.relX));
-			evStates.insert(deviceLocalStatePrefix(evName, "relY"_ba), formatFloatStr(aev.relY));
-			// evStates.insert(deviceStatePrefix(evName, "buttons"_ba), QString::number(aev.buttons, 16).prepend("0x"));
+			const auto &aev = ev.motion;
+			const FloatChars x = formatEventValue(aev.x), y = formatEventValue(aev.y);
+			if constexpr (ToStates)
+				stateValue = x.toByteArray().append(',').append(y.view());
+			if (evTemplate)
+				evMessage = evTemplate->build({ ctrlName, x, y, formatEventValue(aev.relX), formatEventValue(aev.relY) });
 			break;
 		}
 		case EventType::Event_Key: {
-			const auto &aev = static_cast<const DeviceKeyEvent&>(ev);
-			ctrlName = aev.name.toUtf8();
+			const auto &aev = ev.key;
 			stateValue = BoolStr[aev.down];
-			evId = EventIdToken::EID_DeviceKey;
-			evStates.insert(deviceLocalStatePrefix(evName, "key"_ba), QString::number(aev.key()));
-			evStates.insert(deviceLocalStatePrefix(evName, "name"_ba), aev.name);
-			evStates.insert(deviceLocalStatePrefix(evName, "text"_ba), aev.text);
-			evStates.insert(deviceLocalStatePrefix(evName, "down"_ba), stateValue.constData());
-			evStates.insert(deviceLocalStatePrefix(evName, "repeat"_ba), BoolStr[aev.repeat].constData());
-			evStates.insert(deviceLocalStatePrefix(evName, "nativeKey"_ba), QString::number(aev.nativeKey));
-			// evStates.insert(deviceStatePrefix(evName, "mod"_ba), QString::number(aev.modifiers, 16).prepend("0x"));
-			// evStates.insert(deviceStatePrefix(evName, "nativeCode"_ba), QString::number(aev.nativeScanCode));
-			// evStates.insert(deviceStatePrefix(evName, "sdlKey"_ba), QString::number(aev.sdlKey));
-
-			if (const auto modKey = Devices::scanCodeToGeneralModifierType(aev.scancode()); modKey != ModifierKey::MK_NONE) {
-				if (const uint8_t stateId = ModKeyToStateId->value(modKey))
-					Q_EMIT tpStateUpdate(m_stateIds[stateId], stateValue);
+			if (evTemplate)
+				evMessage = evTemplate->build({ QByteArray::number(ev.index), aev.name, aev.text, stateValue, BoolStr[aev.repeat], QByteArray::number(aev.nativeKey) });
+
+			if constexpr (ToStates) {
+				if (const auto modKey = Devices::scanCodeToGeneralModifierType(ev.index); modKey != ModifierKey::MK_NONE) {
+					if (const uint8_t stateId = ModKeyToStateId->value(modKey))
+						updateState(m_stateIds[stateId], stateValue);
+				}
 			}
 
 			break;
 		}
 
 		default:
-			qCWarning(lcPlugin) << "Unhandled Device Event" << ev.timestamp << ev.type << ev.deviceType << ev.deviceUid;
+			qCWarning(lcPlugin) << "Unhandled Device Event" << ev.timestamp << ev.type << ev.devType() << dev->uid();
 			return;
 	}
-	// qCDebug(lcPlugin) << "Device Event" << ev.timestamp << ev.type << ev.deviceType << ev.deviceUid << dev;
-
-	if (g_settings.sendSpecificStates /*|| g_settings.sendGenericStates*/) {
-		const QByteArray stateId = QByteArray(g_deviceEventStateIds[ev.type]) + g_pathSep + ctrlName;
-		const QByteArray fullStateId = m_pluginStateIdPrefix + makeCleanStateId(dev->name()) + g_pathSep + stateId;
+	// qCDebug(lcPlugin) << "Device Event" << ev << dev;
+
+	// Only continuous value updates are held back when TP is falling behind; discrete changes are always sent.
+	const bool defer = m_outputDegraded && EventQueue::laneForType(ev.type) == EventQueue::ContinuousLane;
+	// Continuous controls may also be rate limited, in which case the latest update is held and sent later by flushRateLimited().
+	RateLimiter::Payload *held = nullptr;
+	if (!defer && m_rateLimiter.isEnabled() && EventQueue::laneForType(ev.type) == EventQueue::ContinuousLane) {
+		held = m_rateLimiter.hold(RateLimiter::controlKey(ev.device, ev.type, ev.index), steadyClockNs() / 1'000'000);
+		if (held && !m_rateLimitTmr.isActive())
+			m_rateLimitTmr.start();
+	}
 
-		// QWriteLocker lock(&m_mtxDeviceStates);
-		m_mtxDeviceStates.lockForRead();
-		const QByteArray lastState = m_deviceStates[dev->uid()].value(stateId);
-		m_mtxDeviceStates.unlock();
+	if constexpr (ToStates) {
+		ControlStateIds &ids = controlStateIds(frame.ids, dev, ev.type, ev.index, ev.type == EventType::Event_Key ? ev.key.name : nullptr);
+		const QByteArray &fullStateId = ids.fullStateId;
+		const uint64_t value = ControlStateStore::rawValue(ev, g_settings.valuePrecision);
+		const uint64_t lastValue = m_controlStates.exchange(ev.device, ev.type, ev.index, value);
 
 		// Create a new state if we didn't have a record of this one yet.
-		if (lastState.isNull()) {
-			// pad button names to 3 digits on controllers so states sort alphabetically
-			if (ev.type == EventType::Event_Button && ev.deviceType.testFlag(DeviceType::DT_Controller)) {
-				while (ctrlName.size() < 3)
-					ctrlName.prepend('0');
-			}
-			const QByteArray stateName = (dev->name() + " - "_L1 + g_deviceEventStrings[ev.type] + ' ' + ctrlName).toUtf8();
-			createStateWithDelay(fullStateId, dev->name().toUtf8(), stateName);
-			// qCDebug(lcPlugin) << "Created state" << fullStateId << stateName << "for" << dev->name();
+		if (!ids.created) {
+			createState(fullStateId, frame.ids.device.name, ids.name);
+			ids.created = true;
+			// qCDebug(lcPlugin) << "Created state" << fullStateId << ids.name << "for" << dev->name();
 		}
-		if (lastState != stateValue) {
-			m_mtxDeviceStates.lockForWrite();
-			m_deviceStates[dev->uid()][stateId] = stateValue;
-			m_mtxDeviceStates.unlock();
-			Q_EMIT tpStateUpdate(fullStateId, stateValue);
+		if (lastValue != value) {
+			if (held) {
+				held->stateId = fullStateId;
+				held->stateValue = stateValue;
+			}
+			else if (!defer) {
+				updateState(fullStateId, stateValue);
+			}
+			else if (const auto it = m_deferredStates.find(fullStateId); it != m_deferredStates.end()) {
+				*it = stateValue;
+				++m_mergedStateCount;
+			}
+			else {
+				m_deferredStates.insert(fullStateId, stateValue);
+			}
 			// qCDebug(lcPlugin) << "Updated state" << fullStateId << "to" << stateValue << "evId" << m_eventIds[evId] << "for" << dev->name();
 		}
 	}
 
-	if (g_settings.sendEvents && evId != EventIdToken::EID_ENUM_MAX)
-		Q_EMIT tpTriggerEvent(m_eventIds[evId], evStates);
+	if constexpr (ToEvents) {
+		if (!evMessage.isEmpty()) {
+			if (held) {
+				held->eventMessage = evMessage;
+			}
+			else if (!defer) {
+				Q_EMIT tpWrite(evMessage);
+			}
+			else {
+				const uint64_t key = RateLimiter::controlKey(ev.device, ev.type, ev.index);
+				if (const auto it = m_deferredEvents.find(key); it != m_deferredEvents.end()) {
+					*it = evMessage;
+					++m_droppedEventCount;
+				}
+				else {
+					m_deferredEvents.insert(key, evMessage);
+				}
+			}
+		}
+	}
 }
 
-void Plugin::onDeviceEventPtr(const DeviceEvent *ev)
+// Sends the held updates of rate limited controls whose update interval has passed.
+void Plugin::flushRateLimited()
 {
-	if (!!ev) {
-		onDeviceEvent(*ev);
-		delete ev;
-	}
+	m_rateLimiter.advance(steadyClockNs() / 1'000'000, [this](const RateLimiter::Payload &p) { sendHeldUpdate(p); });
+	if (!m_rateLimiter.hasScheduled())
+		m_rateLimitTmr.stop();
+}
+
+void Plugin::sendHeldUpdate(const RateLimiter::Payload &p)
+{
+	if (!p.stateId.isEmpty())
+		updateState(p.stateId, p.stateValue);
+	if (!p.eventMessage.isEmpty())
+		Q_EMIT tpWrite(p.eventMessage);
+}
+
+// Switches output to degraded mode when the amount of data waiting to be written to TP exceeds the high watermark. While degraded,
+// continuous (axis, motion, etc) state updates and events are held back with only the latest value per state/control kept.
+void Plugin::onOutputHighWatermark(qint64 pending)
+{
+	m_outputDegraded = true;
+	qCWarning(lcPlugin) << "Touch Portal is falling behind with" << pending << "bytes pending, holding back axis and motion updates.";
+}
+
+// Once the backlog drops below the low watermark, the held back updates are sent and normal output resumes.
+void Plugin::onOutputLowWatermark(qint64 /*pending*/)
+{
+	if (!m_outputDegraded)
+		return;
+	m_outputDegraded = false;
+	for (auto it = m_deferredStates.cbegin(), en = m_deferredStates.cend(); it != en; ++it)
+		updateState(it.key(), it.value());
+	for (const QByteArray &msg : std::as_const(m_deferredEvents))
+		Q_EMIT tpWrite(msg);
+	qCInfo(lcPlugin) << "Touch Portal output recovered; sent" << m_deferredStates.size() << "held back state(s) and" << m_deferredEvents.size()
+	                 << "event(s). Total merged state updates:" << m_mergedStateCount << "; dropped events:" << m_droppedEventCount;
+	m_deferredStates.clear();
+	m_deferredEvents.clear();
 }
 
 // value: [!](a|b|h|k|m|s|r)[#|#-#|*] [(,|;| )...]  eg: b1-32,!b8-16, a1 a4; !h
-static bool parseDeviceFilterAction(QStringView value, deviceEventFilter_t &def)
+static bool parseDeviceFilterAction(QStringView value, deviceEventFilterRules_t &rules)
 {
 	static const QRegularExpression ctrlSplitRx(u"[\\s,;]+"_s);
 	static const QHash<char, EventType> evMap({
@@ -897,7 +1247,8 @@ static bool parseDeviceFilterAction(QStringView value, deviceEventFilter_t &def)
 		if ((ev = evMap.value(ctrl.first().toLatin1(), EventType::Event_Generic)) == EventType::Event_Generic)
 			continue;
 
-		EventFilter &ef = def[ev];
+		EventFilterRules &ef = rules[ev];
+		ef.used = true;
 		if (!excl)
 			ef.inclusive = true;
 
@@ -909,25 +1260,112 @@ static bool parseDeviceFilterAction(QStringView value, deviceEventFilter_t &def)
 		}
 		const auto rangePair = ctrl.split('-');
 		rng1 = rangePair.front().toInt(&ok);
-		if (!ok || rng1 < 1)
+		if (!ok || rng1 < 1 || rng1 > UINT16_MAX)
 			continue;
 		if (rangePair.length() == 2) {
 			rng2 = rangePair.at(1).toInt(&ok);
 			if (!ok || rng2 < rng1)
 				continue;
+			rng2 = qMin(rng2, int(UINT16_MAX));
 		}
 		else {
 			rng2 = rng1;
 		}
 
-		for (; rng1 <= rng2; ++rng1)
-			ef.filters.insert(rng1, !excl);
+		ef.ranges.append({ uint16_t(rng1), uint16_t(rng2), !excl });
 
 		qCDebug(lcPlugin) << ctrl << ef;
 	}
 	return true;
 }
 
+// Compiles parsed filter rules into per-type bitsets for a device. Bitsets of types with known control counts are sized to the
+// number of controls, otherwise to the highest index used in the filter.
+static DeviceEventFilterPtr compileDeviceFilter(const deviceEventFilterRules_t &rules, const InputDevice *dev)
+{
+	const ControlCounts counts = dev->controlCounts();
+	auto df = std::make_shared<DeviceEventFilter>();
+	for (int t = 0; t < EventType::EVENT_TYPE_ENUM_MAX; ++t) {
+		const EventFilterRules &r = rules[t];
+		EventFilter &ef = df->types[t];
+		if (!r.used)
+			continue;
+		if (r.wildcard) {
+			ef.passOthers = false;
+			continue;
+		}
+		ef.passOthers = !r.inclusive;
+
+		uint32_t size = 0;
+		for (const auto &rng : r.ranges)
+			size = qMax(size, rng.last + 1U);
+		// control indexes are 1-based
+		uint16_t count = 0;
+		switch (t) {
+			case EventType::Event_Axis:   count = counts.axes; break;
+			case EventType::Event_Button: count = counts.buttons; break;
+			case EventType::Event_Hat:    count = counts.hats; break;
+			default: break;
+		}
+		if (count)
+			size = qMin(size, count + 1U);
+
+		ef.size = size;
+		ef.bits.assign((size + 63) / 64, ef.passOthers ? ~0ULL : 0ULL);
+		for (const auto &rng : r.ranges) {
+			for (uint32_t i = rng.first; i <= rng.last && i < size; ++i) {
+				if (rng.include)
+					ef.bits[i >> 6] |= 1ULL << (i & 63);
+				else
+					ef.bits[i >> 6] &= ~(1ULL << (i & 63));
+			}
+		}
+	}
+	return df;
+}
+
+// Sets or removes (if `filter` is null) the report filter for a device. The filter is also passed on to the device's API to drop
+// filtered events at the source; the check here still covers APIs which don't filter and events already queued before a change.
+static void setDeviceFilter(const InputDevice *dev, DeviceEventFilterPtr filter)
+{
+	DMI()->setEventFilter(dev->uid(), filter);
+	if (dev->handle() >= g_deviceEventFilters->size()) {
+		if (!filter)
+			return;
+		g_deviceEventFilters->resize(dev->handle() + 1);
+	}
+	(*g_deviceEventFilters)[dev->handle()] = std::move(filter);
+}
+
+// Parses a list of 1-based axis indexes and/or ranges, eg. "1-4, 6". Empty or "*" means all axes, returned as index 0.
+static QList<uint16_t> parseAxisIndexList(QStringView value)
+{
+	static const QRegularExpression splitRx(u"[\\s,;]+"_s);
+
+	value = value.trimmed();
+	if (value.isEmpty() || value == QStringView(u"*"))
+		return { 0 };
+
+	QList<uint16_t> ret;
+	bool ok;
+	const auto ranges = value.split(splitRx, Qt::SkipEmptyParts);
+	for (const auto rng : ranges) {
+		const auto rangePair = rng.split('-');
+		const int first = rangePair.front().toInt(&ok);
+		if (!ok || first < 1)
+			continue;
+		int last = first;
+		if (rangePair.length() == 2) {
+			last = rangePair.at(1).toInt(&ok);
+			if (!ok || last < first)
+				continue;
+		}
+		for (int i = first; i <= last && i <= UINT16_MAX; ++i)
+			ret.append(i);
+	}
+	return ret;
+}
+
 // void Plugin::timerEvent(QTimerEvent *ev)
 // {
 // 	if (ev->timerId())
@@ -972,6 +1410,7 @@ void Plugin::onTpConnected(const TPClientQt::TPInfo &info, const QJsonObject &se
 	// m_loadSettingsTmr.start();
 }
 
+// Any message types handled here must also be added to the client's message type filter (see constructor).
 void Plugin::onTpMessage(TPClientQt::MessageType type, const QJsonObject &msg)
 {
 	//qCDebug(lcPlugin) << msg;
@@ -1181,8 +1620,8 @@ void Plugin::pluginAction(TPClientQt::MessageType /*type*/, int act, const QMap<
 				case CA_DisplaysReport:
 					if (g_systemDisplaysCount > 0) {
 						g_systemDisplaysCount = 0;
-						Q_EMIT tpStateUpdate(m_stateIds[SID_DisplaysCount], BoolStr[0]);
-						Q_EMIT tpStateUpdate(m_stateIds[SID_DisplayPrimary], BoolStr[0]);
+						updateState(m_stateIds[SID_DisplaysCount], BoolStr[0]);
+						updateState(m_stateIds[SID_DisplayPrimary], BoolStr[0]);
 					}
 					DMI()->requestDeviceReport(DI_SYSTEM_SCREEN_UID);
 					break;
@@ -1238,9 +1677,18 @@ void Plugin::pluginAction(TPClientQt::MessageType /*type*/, int act, const QMap<
 								DMI()->requestDeviceReport(dev->uid());
 							break;
 						case CA_ClearFilter:
-							g_deviceEventFilters->remove(dev->uid());
+							setDeviceFilter(dev, nullptr);
 							qCInfo(lcPlugin) << "Removed report filter for device" << dev->name();
 							break;
+						case CA_SendAll:
+							setDeviceSinks(dev, OS_All);
+							break;
+						case CA_SendStatesOnly:
+							setDeviceSinks(dev, OS_States);
+							break;
+						case CA_SendEventsOnly:
+							setDeviceSinks(dev, OS_Events);
+							break;
 
 						default:
 							if (subAct != AT_Unknown)
@@ -1254,25 +1702,62 @@ void Plugin::pluginAction(TPClientQt::MessageType /*type*/, int act, const QMap<
 		case AID_DeviceFilter:
 			if (const DeviceListFromActionT devs = getDeviceFromActionData(dataMap); !devs.isEmpty()) {
 				const auto value = dataMap.value("filter"_L1).trimmed();
-				deviceEventFilter_t df;
-				if (!value.isEmpty() && !parseDeviceFilterAction(dataMap.value("filter"_L1), df))
+				deviceEventFilterRules_t rules;
+				if (!value.isEmpty() && !parseDeviceFilterAction(dataMap.value("filter"_L1), rules))
 					break;
 
 				for (const InputDevice *dev : devs) {
 					if (!dev)
 						break;
 					if (value.isEmpty()) {
-						g_deviceEventFilters->remove(dev->uid());
+						setDeviceFilter(dev, nullptr);
 						qCInfo(lcPlugin) << "Removed report filter for device" << dev->name();
 					}
 					else {
-						(*g_deviceEventFilters)[dev->uid()] = df;
-						qCInfo(lcPlugin) << "Added report filter" << df.values() << "for device" << dev->name();
+						setDeviceFilter(dev, compileDeviceFilter(rules, dev));
+						qCInfo(lcPlugin) << "Added report filter" << value << "for device" << dev->name();
 					}
 				}
 			}
 			break;
 
+		case AID_AxisConditioning:
+			if (const DeviceListFromActionT devs = getDeviceFromActionData(dataMap); !devs.isEmpty()) {
+				const QList<uint16_t> axes = parseAxisIndexList(dataMap.value("axes"_L1));
+				if (axes.isEmpty()) {
+					qCWarning(lcPlugin) << "Could not parse any axis numbers from" << dataMap.value("axes"_L1);
+					break;
+				}
+				// deadzones and hysteresis are specified as percentage of full axis range
+				const AxisConditioning cfg = AxisConditioning {
+					dataMap.value("center"_L1).toFloat() * 0.01f,
+					dataMap.value("edge"_L1).toFloat() * 0.01f,
+					dataMap.value("hysteresis"_L1).toFloat() * 0.01f,
+					(uint16_t)std::clamp(dataMap.value("steps"_L1).toInt(), 0, (int)UINT16_MAX)
+				}.bounded();
+
+				for (const InputDevice *dev : devs) {
+					if (!dev)
+						break;
+					if (!dev->type().testFlag(DeviceType::DT_Controller))
+						continue;
+					auto &devCfg = m_axisConditioning[dev->name()];
+					for (const uint16_t axis : axes) {
+						if (cfg.isNull())
+							devCfg.remove(axis);
+						else
+							devCfg.insert(axis, cfg);
+						DMI()->setAxisConditioning(dev->uid(), axis, cfg);
+					}
+					if (devCfg.isEmpty())
+						m_axisConditioning.remove(dev->name());
+					qCInfo(lcPlugin).nospace() << "Set axis conditioning for axes " << axes << " of device " << dev->name()
+					                           << ": center: " << cfg.centerDeadzone << "; edge: " << cfg.edgeDeadzone << "; hysteresis: " << cfg.hysteresis << "; steps: " << cfg.steps;
+				}
+				saveAxisConditioning();
+			}
+			break;
+
 		case AID_DeviceDefault: {
 			QString devName = dataMap.value("device");
 			const QString typeName = dataMap.value("type");
@@ -1295,13 +1780,85 @@ static bool stringToBool(QJsonValue val) {
 	return val.toString().contains(boolRx);
 }
 
-void Plugin::handleSettings(const QJsonObject &settings) const
+void Plugin::handleSettings(const QJsonObject &settings)
 {
 	// qCDebug(lcPlugin) << "Got settings object:" << settings;
 	if (const QJsonValue val{settings.value(g_actionTokenStrings[ST_SendReportStates])}; !val.isUndefined())
 		g_settings.sendSpecificStates = stringToBool(val);
 	if (const QJsonValue val{settings.value(g_actionTokenStrings[ST_SendReportEvents])}; !val.isUndefined())
 		g_settings.sendEvents = stringToBool(val);
+	if (const QJsonValue val{settings.value(g_actionTokenStrings[ST_CoalesceEvents])}; !val.isUndefined())
+		DMI()->setEventCoalescingEnabled(stringToBool(val));
+	if (const QJsonValue val{settings.value(g_actionTokenStrings[ST_HighPriorityInput])}; !val.isUndefined())
+		DMI()->setInputThreadPriority(stringToBool(val) ? QThread::HighestPriority : QThread::NormalPriority);
+	if (const QJsonValue val{settings.value(g_actionTokenStrings[ST_OutputBacklogLimit])}; !val.isUndefined()) {
+		g_settings.outputHighWatermark = qMax(0, val.toVariant().toInt()) * 1024LL;
+		g_settings.outputLowWatermark = g_settings.outputHighWatermark / 4;
+		QMetaObject::invokeMethod(client, [this, high = g_settings.outputHighWatermark, low = g_settings.outputLowWatermark]() {
+			client->setWriteWatermarks(high, low);
+		});
+	}
+	if (const QJsonValue val{settings.value(g_actionTokenStrings[ST_MaxUpdateRate])}; !val.isUndefined()) {
+		const int rate = qBound(0, val.toVariant().toInt(), 1000);
+		const int interval = rate > 0 ? 1000 / rate : 0;
+		if (interval != m_rateLimiter.interval()) {
+			m_rateLimiter.flushAll([this](const RateLimiter::Payload &p) { sendHeldUpdate(p); });
+			m_rateLimiter.setInterval(interval);
+			m_rateLimitTmr.stop();
+		}
+	}
+	if (const QJsonValue val{settings.value(g_actionTokenStrings[ST_ValuePrecision])}; !val.isUndefined()) {
+		g_settings.valuePrecision = qBound(-1, val.toVariant().toInt(), FloatChars::MaxPrecision);
+	}
+	if (const QJsonValue val{settings.value(g_actionTokenStrings[ST_LatencyStatsInterval])}; !val.isUndefined()) {
+		const int interval = qBound(0, val.toVariant().toInt(), 3600);
+		LatencyStats::instance()->setEnabled(interval > 0);
+		if (interval > 0) {
+			m_latencyTmr.start(interval * 1000);
+		}
+		else if (m_latencyTmr.isActive()) {
+			m_latencyTmr.stop();
+			// discards any partial results
+			reportLatencyStats();
+		}
+	}
+}
+
+void Plugin::reportLatencyStats()
+{
+	static const QString stageNames[LatencyStats::LS_ENUM_MAX] { tr("Queue"), tr("Plugin"), tr("Socket"), tr("Total") };
+	static const QByteArray stageIds[LatencyStats::LS_ENUM_MAX] { "queue"_ba, "plugin"_ba, "socket"_ba, "total"_ba };
+
+	const bool enabled = m_latencyTmr.isActive();
+	const auto publishSummary = [&](const QByteArray &id, const QString &name, const LatencyHistogram::Summary &s)
+	{
+		if (!enabled || (!s.count && !m_latencyStateIds.contains(id)))
+			return;
+		const auto ms = [](uint64_t us) { return QByteArray::number(us / 1000.0, 'f', 2); };
+		const QByteArray value = ms(s.p50) + " / "_ba + ms(s.p95) + " / "_ba + ms(s.p99) + " / "_ba + ms(s.max);
+		const QByteArray stateId = m_pluginStateIdPrefix + PLUGIN_STR_STATEID_LATENCY PLUGIN_STR_PATH_SEP + id;
+		if (!m_latencyStateIds.contains(id)) {
+			createState(stateId, PLUGIN_STR_CAT_LATENCY_NAME, (tr("Latency (ms: p50 / p95 / p99 / max)") + " - "_L1 + name).toUtf8(), value, true);
+			m_latencyStateIds.insert(id);
+		}
+		updateState(stateId, value);
+		if (s.count)
+			qCInfo(lcPlugin).nospace() << "Input latency - " << name << ": " << value.constData() << " ms (p50 / p95 / p99 / max) of " << s.count << " events";
+	};
+
+	LatencyStats *ls = LatencyStats::instance();
+	for (int i = 0; i < LatencyStats::LS_ENUM_MAX; ++i)
+		publishSummary(stageIds[i], stageNames[i], ls->stage(LatencyStats::Stage(i)).takeSummary());
+	for (int i = 0; i < EventType::EVENT_TYPE_ENUM_MAX; ++i)
+		publishSummary("type."_ba + g_deviceEventStrings[i], QString::fromLatin1(g_deviceEventStrings[i]) + tr(" Events"), ls->eventType(EventType(i)).takeSummary());
+	for (int h = 1; h < LatencyStats::MaxDevices; ++h) {
+		LatencyHistogram *hist = ls->device(h);
+		if (!hist)
+			continue;
+		const LatencyHistogram::Summary s = hist->takeSummary();
+		if (const InputDevice *dev = DMI()->deviceForHandle(h))
+			publishSummary("device."_ba + makeCleanStateId(dev->name()), dev->name(), s);
+	}
 }
 
 #include "moc_Plugin.cpp"
@@ -21,8 +21,14 @@ to any 3rd-party components used within.
 #pragma once
 
 #include <QObject>
+#include <QSet>
 #include <QTimer>
+#include <span>
+#include <vector>
 
+#include "ControlStateStore.h"
+#include "JsonMessageTemplate.h"
+#include "RateLimiter.h"
 #include "devices.h"
 #include "strings.h"
 #include "TPClientQt.h"
@@ -34,10 +40,19 @@ QT_END_NAMESPACE
 
 
 namespace Devices {
-struct DeviceEvent;
+struct EventRecord;
 // struct DisplayInfo;
 }
 class InputDevice;
+struct DeviceEventFrame;
+
+// Device name and type strings, pre-encoded for use in state and event data. Rebuilt when the device is renamed.
+struct DevicePresentation {
+	QByteArray name;       // UTF-8 device name; also the state group name
+	QByteArray stateName;  // device name cleaned up for use in state IDs
+	QByteArray typeName;   // UTF-8 device type name
+	QByteArray typeId;     // numeric device type flags
+};
 
 class Plugin : public QObject
 {
@@ -51,7 +66,7 @@ class Plugin : public QObject
 	Q_SIGNALS:
 		void tpConnect();
 		void tpDisconnect();
-		void tpStateUpdate(const QByteArray &, const QByteArray &) const;
+		void tpStateUpdate(const QByteArray &, const QByteArray &, bool force = false) const;  // force bypasses the client's unchanged value check
 		// void tpStateUpdateStr(const QByteArray &, QStringView) const;
 		void tpStateCreate(const QByteArray &stateId, const QByteArray &parent, const QByteArray &descript, const QByteArray &deflt = QByteArray(), bool = false) const;
 		void tpStateRemove(const QByteArray &) const;
@@ -60,6 +75,7 @@ class Plugin : public QObject
 		// void tpStateListUpdate(const QByteArray &, const QByteArrayList &) const;
 		void tpStateListUpdate(const QByteArray &, const QStringList &) const;
 		void tpTriggerEvent(const QByteArray &, const QJsonObject &) const;
+		void tpWrite(const QByteArray &) const;  // pre-serialized message
 		// void tpChoiceUpdateInstance(const QByteArray &, const QByteArray &, const QByteArrayList &) const;
 		// void tpChoiceUpdateInstanceStrList(const QByteArray &, const QByteArray &, const QStringList &) const;
 		// void tpConnectorUpdate(const QByteArray &, quint8, bool) const;
@@ -88,33 +104,38 @@ class Plugin : public QObject
 		// void loadPluginSettings();
 		void loadDefaultDevices();
 		void saveDefaultDevices() const;
+		void loadAxisConditioning();
+		void saveAxisConditioning() const;
+		void applyAxisConditioning(const InputDevice *dev) const;
 		// void loadStartupSettings();
 
-		void createStateWithDelay(const QByteArray &stateId, const QByteArray &parent, const QByteArray &name, const QByteArray &dflt = QByteArray(), bool force = false, int delayMs = 2) const;
+		void createState(const QByteArray &stateId, const QByteArray &parent, const QByteArray &name, const QByteArray &dflt = QByteArray(), bool force = false);
+		void updateState(const QByteArray &stateId, const QByteArray &value);
+		void sendNextQueuedState();
 
 		void updatePluginState(Strings::ActionTokens state, bool direct = false) const;
 		void updateDisplayInfoStates(const Devices::DisplayInfo &si);
 		void removeDisplayStates(short nDisplay);
-		void setupKeyboardStates(const InputDevice *dev) const;
+		void setupKeyboardStates(const InputDevice *dev);
+		void setupControllerStates(const InputDevice *dev);
 
 		void sendInstanceLists() const;
 		void sendDeviceInstanceUpdates(const InputDevice *dev) const;
 		void sendFirstAssignedDeviceStateUpdate(Devices::DeviceTypes devType) const;
 		void sendDefaultAssignedDeviceStateUpdate(Devices::DeviceTypes devType) const;
-		void sendFullStatusReport() const;
+		void sendFullStatusReport();
 		// void sendDeviceMatchOptionChoiceLists(int actionId, const QByteArray &instanceId, bool na) const;
 
 		void setDefaultDeviceForTypeName(const QString &typeName, const QString &deviceName, bool notify = true, bool save = true);
 
 		void dispatchDeviceEvent(const InputDevice *dev, Strings::ActionTokens event, Strings::StateIdToken stateId = Strings::StateIdToken::SID_ENUM_MAX, Strings::EventIdToken eventId = Strings::EID_ENUM_MAX) const;
-		void onDeviceConnected(const QByteArray &uid) const;
-		void onDeviceRemoved(const QByteArray &uid) const;
-		void onDeviceReportStarted(const InputDevice *dev) const;
+		void onDeviceConnected(const QByteArray &uid);
+		void onDeviceRemoved(const QByteArray &uid);
+		void onDeviceReportStarted(const InputDevice *dev);
 		void onDeviceReportStopped(const InputDevice *dev) const;
-		void onDeviceNameChanged(const InputDevice *dev, const QString &name) const;
+		void onDeviceNameChanged(const InputDevice *dev, const QString &name);
 		void onDeviceStateChanged(const InputDevice *dev, Devices::DeviceState newState, Devices::DeviceState previousState = Devices::DeviceState::DS_Unknown) const;
-		void onDeviceEvent(const Devices::DeviceEvent &ev);
-		void onDeviceEventPtr(const Devices::DeviceEvent *ev);
+		void onDeviceEventBatch(const InputDevice *dev, std::span<const Devices::EventRecord> events);
 
 		void onClientDisconnect();
 		void onClientError(QAbstractSocket::SocketError);
@@ -123,11 +144,50 @@ class Plugin : public QObject
 
 		void dispatchAction(TPClientQt::MessageType type, const QJsonObject &msg);
 		void pluginAction(TPClientQt::MessageType type, int act, const QMap<QString, QString> &dataMap, qint32 connectorValue);
-		void handleSettings(const QJsonObject &settings) const;
+		void handleSettings(const QJsonObject &settings);
+		void reportLatencyStats();
+		void onOutputHighWatermark(qint64 pending);
+		void onOutputLowWatermark(qint64 pending);
+		void flushRateLimited();
+		void sendHeldUpdate(const RateLimiter::Payload &p);
 
 	private:
+		// Outputs which device events are sent to.
+		enum OutputSink : uint8_t {
+			OS_None   = 0x00,
+			OS_States = 0x01,
+			OS_Events = 0x02,
+			OS_All    = OS_States | OS_Events,
+		};
+
+		// Prebuilt state ID and name for one device control.
+		struct ControlStateIds {
+			QByteArray stateId;      // device-relative ID, eg. "axis.1"
+			QByteArray fullStateId;  // full TP state ID
+			QByteArray name;         // state display name
+			bool created {false};    // true once the state has been (queued to be) created
+		};
+		// Per-device state IDs, built when the device connects and rebuilt when it is renamed. Control entries are indexed by event type
+		// and control index, and filled in the first time a control is seen since device descriptors don't provide control counts.
+		struct DeviceStateIdTable {
+			DevicePresentation device;
+			QByteArray stateIdPrefix;  // full state ID up to the device-specific part
+			std::vector<ControlStateIds> controls[Devices::EventType::EVENT_TYPE_ENUM_MAX];
+			JsonMessageTemplate eventTemplates[Devices::EventType::EVENT_TYPE_ENUM_MAX];  // built on first event of each type
+		};
+
+		friend struct DeviceEventFrame;
+
 		typedef QVarLengthArray<InputDevice *, 1> DeviceListFromActionT;
 		DeviceListFromActionT getDeviceFromActionData(const QMap<QString, QString> &dataMap);
+		template <bool ToStates, bool ToEvents>
+		void handleDeviceEvent(DeviceEventFrame &frame, const Devices::EventRecord &ev);
+		uint8_t outputSinks(const InputDevice *dev) const;
+		void setDeviceSinks(const InputDevice *dev, uint8_t sinks);
+		static DevicePresentation devicePresentation(const InputDevice *dev);
+		DeviceStateIdTable &buildStateIdTable(const InputDevice *dev);
+		ControlStateIds &controlStateIds(DeviceStateIdTable &table, const InputDevice *dev, Devices::EventType type, uint16_t index, const char *keyName = nullptr);
+		const JsonMessageTemplate *deviceEventTemplate(DeviceStateIdTable &table, const InputDevice *dev, Devices::EventType type) const;
 
 		const QByteArray m_pluginId;
 		const QByteArray m_pluginStateIdPrefix;
@@ -137,12 +197,38 @@ class Plugin : public QObject
 		QThread *clientThread = nullptr;
 		QTimer m_loadSettingsTmr;
 		QTimer m_deviceListTmr;
+		QTimer m_latencyTmr;
+		QTimer m_rateLimitTmr;
+		QTimer m_stateCreateTmr;
 		// QPair<QByteArray, bool> m_lastDeviceUid;
 		QByteArray m_stateIds[Strings::SID_ENUM_MAX];
 		QByteArray m_eventIds[Strings::EID_ENUM_MAX];
 		QByteArray m_choiceListIds[Strings::CLID_ENUM_MAX];
 
-		QReadWriteLock m_mtxDeviceStates;
-		QHash<QByteArray, QHash<QByteArray, QByteArray>> m_deviceStates;
+		ControlStateStore m_controlStates;  // last values of device controls, for change detection
+		QHash<QByteArray, QByteArray> m_displayStates;  // state ID -> value
+		QHash<Devices::DeviceHandle, DeviceStateIdTable> m_stateIdTables;
+		std::vector<uint8_t> m_deviceSinks;  // OutputSink flags per device handle; devices past the end have all outputs enabled
 		QHash<Devices::DeviceTypes, QString> m_defaultDevices;
+		QHash<QString, QHash<uint16_t, Devices::AxisConditioning>> m_axisConditioning;  // device name -> axis index (0 = all) -> settings
+		QSet<QByteArray> m_latencyStateIds;  // latency statistics states which have been created
+		// States waiting to be created, in order, and their latest values; the last created state stays here until the next timer tick.
+		struct PendingState {
+			QByteArray parent;
+			QByteArray name;
+			QByteArray value;
+			bool force {false};
+			bool sent {false};     // create message was sent
+			bool updated {false};  // value changed after create message was sent
+		};
+		QHash<QByteArray, PendingState> m_pendingStates;
+		QList<QByteArray> m_stateCreateQueue;
+		QByteArray m_lastCreatedState;
+		// Output state while Touch Portal isn't keeping up (see onOutputHighWatermark())
+		QHash<QByteArray, QByteArray> m_deferredStates;  // state ID -> latest value
+		QHash<uint64_t, QByteArray> m_deferredEvents;  // RateLimiter::controlKey() -> latest event message
+		RateLimiter m_rateLimiter;  // per-control update rate limit of continuous controls
+		bool m_outputDegraded = false;
+		quint64 m_mergedStateCount = 0;
+		quint64 m_droppedEventCount = 0;
 };
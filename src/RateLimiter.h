@@ -0,0 +1,162 @@
+/*
+Device Input Plugin for Touch Portal
+Copyright Maxim Paperno; all rights reserved.
+
+This file may be used under the terms of the GNU
+General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+A copy of the GNU General Public License is available at <http://www.gnu.org/licenses/>.
+
+This project may also use 3rd-party Open Source software under the terms
+of their respective licenses. The copyright notice above does not apply
+to any 3rd-party components used within.
+*/
+
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <algorithm>
+#include <array>
+
+#include "device/events.h"
+
+// Limits how often each device control sends updates. The first change after a quiet period goes out right away; changes arriving
+// sooner than the minimum interval since the last update are held (only the latest kept) and delivered when the interval ends,
+// so the final value after a control stops moving is never lost.
+//
+// Held controls are scheduled on a hashed timer wheel which is advanced by one shared timer, instead of using a timer per control.
+// Not thread-safe; all methods must be called from the same thread.
+class RateLimiter
+{
+	public:
+		static constexpr int WheelSize = 64;  // slots
+		static constexpr int TickMs = 5;      // slot resolution
+
+		// Latest held update of one control; empty members have nothing to send.
+		struct Payload
+		{
+			QByteArray stateId;
+			QByteArray stateValue;
+			QByteArray eventMessage;
+		};
+
+		static uint64_t controlKey(Devices::DeviceHandle device, Devices::EventType type, uint16_t index) {
+			return (uint64_t(device) << 32) | (uint32_t(type) << 16) | index;
+		}
+
+		int interval() const { return m_intervalMs; }
+		bool isEnabled() const { return m_intervalMs > 0; }
+		// Sets the minimum time between updates of each control, or 0 to disable limiting. Any held updates are discarded.
+		void setInterval(int ms)
+		{
+			m_intervalMs = std::max(ms, 0);
+			clear();
+		}
+
+		// Returns null if the control may send an update at `nowMs` (which is then recorded as its last update time). Otherwise the update
+		// must be held by storing it in the returned payload, which is delivered by advance() once the control's interval has passed.
+		Payload *hold(uint64_t key, uint64_t nowMs)
+		{
+			Control &c = m_controls[key];
+			if (c.due)
+				return &c.payload;
+			if (nowMs - c.lastUpdate >= uint64_t(m_intervalMs)) {
+				c.lastUpdate = nowMs;
+				return nullptr;
+			}
+			c.due = c.lastUpdate + m_intervalMs;
+			m_wheel[(c.due / TickMs) % WheelSize].append(key);
+			++m_scheduledCount;
+			return &c.payload;
+		}
+
+		// True if any held updates are waiting for delivery.
+		bool hasScheduled() const { return m_scheduledCount > 0; }
+
+		// Delivers all held updates which are due at `nowMs` by calling `deliver(const Payload &)` for each one.
+		template <typename Func>
+		void advance(uint64_t nowMs, Func &&deliver)
+		{
+			const uint64_t nowTick = nowMs / TickMs;
+			if (!m_scheduledCount) {
+				m_lastTick = nowTick;
+				return;
+			}
+			// The last visited slot is visited again since updates may have been scheduled later within the same tick.
+			// Each slot is visited at most once, even if the timer was late by more than a full wheel turn.
+			uint64_t tick = nowTick - m_lastTick >= uint64_t(WheelSize) ? nowTick - WheelSize + 1 : m_lastTick;
+			for (; tick <= nowTick && m_scheduledCount; ++tick) {
+				QList<uint64_t> &slot = m_wheel[tick % WheelSize];
+				slot.removeIf([&](uint64_t key) {
+					const auto it = m_controls.find(key);
+					if (it == m_controls.end())
+						return true;  // control was removed
+					Control &c = it.value();
+					if (!c.due)
+						return true;  // stale entry of a removed and re-added control
+					if (c.due > nowMs)
+						return false;  // due on a later turn of the wheel
+					deliver(std::as_const(c.payload));
+					c.payload = Payload();
+					c.lastUpdate = nowMs;
+					c.due = 0;
+					--m_scheduledCount;
+					return true;
+				});
+			}
+			m_lastTick = nowTick;
+		}
+
+		// Delivers all held updates right away, eg. before changing the interval.
+		template <typename Func>
+		void flushAll(Func &&deliver)
+		{
+			for (Control &c : m_controls) {
+				if (c.due)
+					deliver(std::as_const(c.payload));
+			}
+			clear();
+		}
+
+		// Forgets all controls of a device, discarding any held updates.
+		void removeDevice(Devices::DeviceHandle device)
+		{
+			m_controls.removeIf([&](QHash<uint64_t, Control>::iterator it) {
+				if ((it.key() >> 32) != device)
+					return false;
+				if (it->due)
+					--m_scheduledCount;
+				return true;
+			});
+		}
+
+		void clear()
+		{
+			m_controls.clear();
+			for (QList<uint64_t> &slot : m_wheel)
+				slot.clear();
+			m_scheduledCount = 0;
+		}
+
+	private:
+		struct Control
+		{
+			uint64_t lastUpdate {0};
+			uint64_t due {0};  // time the held payload will be delivered; 0 if nothing is held
+			Payload payload;
+		};
+
+		QHash<uint64_t, Control> m_controls;
+		std::array<QList<uint64_t>, WheelSize> m_wheel;
+		uint64_t m_lastTick {0};
+		int m_scheduledCount {0};
+		int m_intervalMs {0};
+};
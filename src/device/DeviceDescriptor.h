@@ -20,6 +20,9 @@ to any 3rd-party components used within.
 
 #pragma once
 
+#include <QMutex>
+#include <limits>
+
 #include "logging.h"
 #include "devices.h"
 
@@ -58,6 +61,8 @@ struct DeviceDescriptor
 	uint8_t instance { 0 };  // for multiple devices of same type
 	QString name {};
 	DeviceHwData hwData {};
+	Devices::DeviceHandle handle { 0 };  // assigned via Devices::deviceHandleForUid()
+	Devices::ControlCounts controls {};  // set when the device is opened
 
 	friend QDebug operator<<(QDebug dbg, const DeviceDescriptor &dd) {
 		QDebugStateSaver saver(dbg);
@@ -68,6 +73,7 @@ struct DeviceDescriptor
 		  << dd.name << DBG_SEP
 		  << dd.instance << DBG_SEP
 		  << dd.uid << DBG_SEP
+		  << dd.handle << DBG_SEP
 		  // << dd.guid << DBG_SEP
 			<< dd.hwData
 			<< '}';
@@ -75,4 +81,25 @@ struct DeviceDescriptor
 	}
 };
 
+namespace Devices {
+
+// Returns the handle for a device UID, assigning a new one the first time the UID is seen.
+// Handles stay associated with the same UID for the lifetime of the process, across device removal and re-connection.
+inline DeviceHandle deviceHandleForUid(const QByteArray &uid)
+{
+	static QBasicMutex mutex;
+	static QHash<QByteArray, DeviceHandle> handles;
+
+	if (uid.isEmpty())
+		return 0;
+	const QMutexLocker lock(&mutex);
+	if (const auto it = handles.constFind(uid); it != handles.cend())
+		return it.value();
+	if (handles.size() >= std::numeric_limits<DeviceHandle>::max())
+		return 0;
+	return handles.insert(uid, DeviceHandle(handles.size() + 1)).value();
+}
+
+}
+
 Q_DECLARE_METATYPE(DeviceDescriptor)
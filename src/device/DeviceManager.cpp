@@ -34,6 +34,14 @@ to any 3rd-party components used within.
 
 using namespace Devices;
 
+template <typename T>
+static void logEventPoolStats(const char *name)
+{
+	const EventPoolStats st = EventPool<T>::instance().stats();
+	if (st.hits || st.misses)
+		qCDebug(lcDevices).nospace() << "Event pool " << name << ": hits: " << st.hits << "; misses: " << st.misses << "; slabs: " << st.slabs;
+}
+
 class DeviceManagerPublic : public DeviceManager {
 	public:
 		explicit DeviceManagerPublic() : DeviceManager(nullptr) {}
@@ -62,10 +70,14 @@ class DeviceManagerPrivate
 		q_ptr->connect(m, &IApiManager::deviceDiscovered, q_ptr, &DeviceManager::onPlatformDeviceDiscovered /*, Qt::QueuedConnection*/);
 		q_ptr->connect(m, &IApiManager::deviceRemoved, q_ptr, &DeviceManager::onPlatformDeviceRemoved/*, Qt::QueuedConnection*/);
 		q_ptr->connect(m, &IApiManager::deviceEvent, q_ptr, &DeviceManager::onPlatformDeviceEvent /*, Qt::QueuedConnection*/);
+		// Always queued, even on the same thread, so that all the events produced during one loop iteration get processed together.
+		q_ptr->connect(m, &IApiManager::eventsAvailable, q_ptr, [this, m]() { processQueuedEvents(m); }, Qt::QueuedConnection);
+		q_ptr->connect(m, &IApiManager::deviceControlsDetected, q_ptr, &DeviceManager::onPlatformDeviceControlsDetected);
 		q_ptr->connect(m, &IApiManager::deviceReportToggled, q_ptr, &DeviceManager::onPlatformDeviceReportToggled /*, Qt::QueuedConnection*/);
 		q_ptr->connect(m, &IApiManager::displayDetected, q_ptr, &DeviceManager::displayDetected /*, Qt::QueuedConnection*/);
 		q_ptr->connect(m, &IApiManager::displayRemoved, q_ptr, &DeviceManager::displayRemoved /*, Qt::QueuedConnection*/);
 
+		m->setEventQueueCapacity(eventQueueCapacity);
 		m->init();
 		// if (m->init())
 		// 	m->scanDevices();
@@ -73,11 +85,43 @@ class DeviceManagerPrivate
 
 	void deinitManagerIface(IApiManager *m)
 	{
+		const EventQueue *queue = m->eventQueue();
+		qCInfo(lcDevices).nospace() << m->metaObject()->className() << " event queue peak depth: discrete " << queue->peakDepth(EventQueue::DiscreteLane)
+		                            << ", continuous " << queue->peakDepth(EventQueue::ContinuousLane) << "; capacity " << queue->capacity();
 		m->deinit();
 		q_ptr->disconnect(m, nullptr, q_ptr, nullptr);
 		m->deleteLater();
 	}
 
+	// Drains the manager's event queue and emits the events in per-device frames, discrete events first. A frame ends with a record
+	// flagged as FrameEnd, when the next event is from a different device or queue lane, or when there are no more queued events.
+	void processQueuedEvents(IApiManager *m)
+	{
+		EventQueue *queue = m->eventQueue();
+		EventQueue::Lane frameLane = EventQueue::DiscreteLane;
+		queue->consume([this, &frameLane](const EventRecord &ev, EventQueue::Lane lane) {
+			if (!eventFrame.isEmpty() && (eventFrame.constFirst().device != ev.device || lane != frameLane))
+				emitEventFrame();
+			frameLane = lane;
+			if (!ev.isFrameMarker())
+				eventFrame.append(ev);
+			if (ev.isFrameEnd())
+				emitEventFrame();
+		});
+		emitEventFrame();
+		if (const uint64_t overflows = queue->takeNewOverflows())
+			qCWarning(lcDevices) << "Device event queue overflowed, dropped" << overflows << "event(s). Queue capacity:" << queue->capacity();
+	}
+
+	void emitEventFrame()
+	{
+		if (eventFrame.isEmpty())
+			return;
+		if (InputDevice *dev = devicesByHandle.value(eventFrame.constFirst().device, nullptr))
+			Q_EMIT q_ptr->deviceEventBatch(dev, std::span<const EventRecord>(eventFrame.constData(), eventFrame.size()));
+		eventFrame.clear();
+	}
+
 	void setDeviceNameWithInstance(InputDevice *dev) const
 	{
 		const auto i = dev->instance();
@@ -142,6 +186,13 @@ class DeviceManagerPrivate
 
 	QByteArrayList discoveryOrder;  // list of device UIDs in order of discovery; devices removed from here when disconnected
 	QHash<QByteArray, InputDevice *> devices;
+	QList<InputDevice *> devicesByHandle;  // indexed by device handle
+	QHash<DeviceHandle, DeviceEventFilterPtr> eventFilters;  // compiled report filters of SDL devices, passed on again when the SDL manager is re-created
+	std::size_t eventQueueCapacity { DEVICE_EVENT_QUEUE_DEFAULT_CAPACITY };
+	bool coalesceEvents { true };
+	bool useInputThread { true };
+	QThread::Priority inputThreadPriority { QThread::NormalPriority };
+	QVarLengthArray<EventRecord, 64> eventFrame;
 	std::atomic_bool initComplete { false };
 	std::atomic_bool globalPending { false };
 
@@ -158,6 +209,7 @@ DeviceManager::DeviceManager(QObject *parent) :
   d_ptr(new DeviceManagerPrivate(this))
 {
 	qRegisterMetaType<DeviceDescriptor>();
+	qRegisterMetaType<Devices::EventRecord>();
 	qRegisterMetaType<Devices::DeviceEvent>();
 	qRegisterMetaType<Devices::DeviceEvent*>();
 	qRegisterMetaType<Devices::DevicePositionEvent>();
@@ -168,6 +220,7 @@ DeviceManager::DeviceManager(QObject *parent) :
 	qRegisterMetaType<Devices::DeviceMotionEvent>();
 	qRegisterMetaType<Devices::DeviceScrollEvent>();
 	qRegisterMetaType<Devices::DisplayInfo>();
+	qRegisterMetaType<Devices::ControlCounts>();
 }
 
 DeviceManager::~DeviceManager()
@@ -184,6 +237,32 @@ InputDevice *DeviceManager::device(const QByteArray &uid) const
 	return d->devices.value(uid, nullptr);
 }
 
+InputDevice *DeviceManager::deviceForHandle(DeviceHandle handle) const
+{
+	Q_DC(DeviceManager);
+	return d->devicesByHandle.value(handle, nullptr);
+}
+
+std::size_t DeviceManager::eventQueueDepth(EventQueue::Lane lane) const
+{
+	Q_DC(DeviceManager);
+	std::size_t depth = 0;
+	for (const IApiManager *m : std::initializer_list<const IApiManager *>{ d->sdlManager, d->nativeManager })
+		if (m)
+			depth += m->eventQueue()->depth(lane);
+	return depth;
+}
+
+std::size_t DeviceManager::eventQueuePeakDepth(EventQueue::Lane lane) const
+{
+	Q_DC(DeviceManager);
+	std::size_t depth = 0;
+	for (const IApiManager *m : std::initializer_list<const IApiManager *>{ d->sdlManager, d->nativeManager })
+		if (m)
+			depth = std::max(depth, m->eventQueue()->peakDepth(lane));
+	return depth;
+}
+
 InputDevice *DeviceManager::deviceByName(const QString &name, Qt::MatchFlags matchFlags) const {
 	return devicesByName(name, matchFlags, 1).value(0, nullptr);
 }
@@ -303,7 +382,13 @@ void DeviceManager::init()
 	if (d->nativeManager)
 		d->initManagerIface(d->nativeManager);
 
-	d->sdlManager = new SDLManager(this);
+	// no parent since it may be moved to its own thread
+	d->sdlManager = new SDLManager();
+	d->sdlManager->setEventCoalescingEnabled(d->coalesceEvents);
+	d->sdlManager->setUseInputThread(d->useInputThread);
+	d->sdlManager->setInputThreadPriority(d->inputThreadPriority);
+	for (auto it = d->eventFilters.cbegin(), en = d->eventFilters.cend(); it != en; ++it)
+		d->sdlManager->setEventFilter(it.key(), it.value());
 	d->initManagerIface(d->sdlManager);
 
 	d->globalPending = false;
@@ -333,6 +418,13 @@ void DeviceManager::deinit()
 
 	d->globalPending = false;
 	d->initComplete = false;
+
+	logEventPoolStats<DeviceAxisEvent>("Axis");
+	logEventPoolStats<DeviceHatEvent>("Hat");
+	logEventPoolStats<DeviceButtonEvent>("Button");
+	logEventPoolStats<DeviceScrollEvent>("Scroll");
+	logEventPoolStats<DeviceMotionEvent>("Motion");
+	logEventPoolStats<DeviceKeyEvent>("Key");
 	qCDebug(lcDevices) << "DeviceManager deinit completed";
 }
 
@@ -350,6 +442,30 @@ void DeviceManager::resetControllerUpdateInterval()
 		d->sdlManager->setActiveScanInterval(d->sdlManager->defaultActiveScanInterval());
 }
 
+void DeviceManager::setEventCoalescingEnabled(bool enable)
+{
+	Q_D(DeviceManager);
+	d->coalesceEvents = enable;
+	if (d->sdlManager)
+		d->sdlManager->setEventCoalescingEnabled(enable);
+}
+
+void DeviceManager::setInputThreadEnabled(bool enable)
+{
+	Q_D(DeviceManager);
+	if (d->initComplete)
+		qCWarning(lcDevices) << "Input thread setting change will take effect after re-initialization.";
+	d->useInputThread = enable;
+}
+
+void DeviceManager::setInputThreadPriority(QThread::Priority priority)
+{
+	Q_D(DeviceManager);
+	d->inputThreadPriority = priority;
+	if (d->sdlManager)
+		d->sdlManager->setInputThreadPriority(priority);
+}
+
 void DeviceManager::updateDevices()
 {
 	Q_D(DeviceManager);
@@ -419,6 +535,42 @@ void DeviceManager::requestDeviceReport(const QByteArray &uid) const
 	}
 }
 
+void DeviceManager::setAxisConditioning(const QByteArray &uid, uint16_t axis, const Devices::AxisConditioning &cfg) const
+{
+	Q_DC(DeviceManager);
+	if (const InputDevice *dev = d->devices.value(uid); dev && dev->api() == DeviceAPI::DA_SDL && d->sdlManager)
+		d->sdlManager->setAxisConditioning(dev->handle(), axis, cfg);
+}
+
+void DeviceManager::clearAxisConditioning(const QByteArray &uid) const
+{
+	Q_DC(DeviceManager);
+	if (const InputDevice *dev = d->devices.value(uid); dev && dev->api() == DeviceAPI::DA_SDL && d->sdlManager)
+		d->sdlManager->clearAxisConditioning(dev->handle());
+}
+
+void DeviceManager::setEventFilter(const QByteArray &uid, const Devices::DeviceEventFilterPtr &filter)
+{
+	Q_D(DeviceManager);
+	const InputDevice *dev = d->devices.value(uid);
+	if (!dev || dev->api() != DeviceAPI::DA_SDL)
+		return;
+	if (filter)
+		d->eventFilters.insert(dev->handle(), filter);
+	else
+		d->eventFilters.remove(dev->handle());
+	if (d->sdlManager)
+		d->sdlManager->setEventFilter(dev->handle(), filter);
+}
+
+void DeviceManager::setEventQueueCapacity(std::size_t capacity)
+{
+	Q_D(DeviceManager);
+	if (d->initComplete)
+		qCWarning(lcDevices) << "Event queue capacity change will take effect after re-initialization.";
+	d->eventQueueCapacity = capacity;
+}
+
 void DeviceManager::onPlatformDeviceDiscovered(const DeviceDescriptor &dd)
 {
 	Q_D(DeviceManager);
@@ -431,6 +583,11 @@ void DeviceManager::onPlatformDeviceDiscovered(const DeviceDescriptor &dd)
 		connect(dev, &InputDevice::nameChanged, this, &DeviceManager::onDevNameChanged);
 		connect(dev, &InputDevice::stateChanged, this, &DeviceManager::onDevStateChanged);
 		d->devices.insert(dd.uid, dev);
+		if (const DeviceHandle h = dev->handle()) {
+			if (d->devicesByHandle.size() <= h)
+				d->devicesByHandle.resize(h + 1, nullptr);
+			d->devicesByHandle[h] = dev;
+		}
 
 		Q_EMIT deviceDiscovered(dd.uid);
 		qCDebug(lcDevices) << "Added new device" << dd;
@@ -465,17 +622,25 @@ void DeviceManager::onPlatformDeviceRemoved(const QByteArray &uid)
 void DeviceManager::onPlatformDeviceEvent(DeviceEvent *ev)
 {
 	Q_DC(DeviceManager);
+	const DeviceEventPtr evp(ev);  // event memory is recycled on return
 	// qCDebug(lcDevices) << "Device Event" << ev->timestamp << ev->type << ev->deviceType << ev->deviceUid;
 	if (InputDevice *dev = d->devices.value(ev->deviceUid) /*; dev && dev->state() == DeviceState::DS_Reporting*/) {
-		ev->device = dev;
-		// Q_EMIT deviceEvent(*ev);
-		Q_EMIT deviceEventPtr(ev);
-	}
-	else {
-		delete ev;
+		EventRecord rec {};
+		ev->toRecord(rec);
+		rec.device = dev->handle();
+		rec.steadyTime = steadyClockNs();
+		rec.flags |= EventRecord::FrameEnd;
+		Q_EMIT deviceEventBatch(dev, std::span<const EventRecord>(&rec, 1));
 	}
 }
 
+void DeviceManager::onPlatformDeviceControlsDetected(const QByteArray &uid, const ControlCounts &counts)
+{
+	Q_DC(DeviceManager);
+	if (InputDevice *dev = d->devices.value(uid))
+		dev->setControlCounts(counts);
+}
+
 void DeviceManager::onPlatformDeviceReportToggled(const QByteArray &uid, bool started)
 {
 	Q_DC(DeviceManager);
@@ -22,8 +22,11 @@ to any 3rd-party components used within.
 
 #include <QObject>
 #include <QCoreApplication>
+#include <QThread>
+#include <span>
 
-#include "events.h"
+#include "EventFilter.h"
+#include "EventQueue.h"
 
 namespace Devices {
 // class DeviceEvent;
@@ -46,6 +49,7 @@ class DeviceManager : public QObject
 		static DeviceManager *instance();
 
 		InputDevice *device(const QByteArray &uid) const;
+		InputDevice *deviceForHandle(Devices::DeviceHandle handle) const;
 		InputDevice *deviceByName(const QString &name, Qt::MatchFlags matchFlags = Qt::MatchExactly | Qt::MatchCaseSensitive) const;
 		QList<InputDevice *> devicesByName(const QString &name, Qt::MatchFlags matchFlags = Qt::MatchExactly | Qt::MatchCaseSensitive, qsizetype maxHits = 0) const;
 		QList<InputDevice*> devices(
@@ -53,6 +57,9 @@ class DeviceManager : public QObject
 		    DeviceSortOrder order = DeviceSortOrder::Unordered,
 		    Devices::DeviceTypes type = Devices::DeviceType::DT_Unknown,
 		    qsizetype maxHits = 0) const;
+		// Current and highest number of events waiting to be processed in a priority lane of the device event queues.
+		std::size_t eventQueueDepth(Devices::EventQueue::Lane lane) const;
+		std::size_t eventQueuePeakDepth(Devices::EventQueue::Lane lane) const;
 		QStringList deviceNames(
 		    Devices::DeviceState minState = Devices::DeviceState::DS_Seen,
 		    DeviceSortOrder order = DeviceSortOrder::Unordered,
@@ -63,11 +70,21 @@ class DeviceManager : public QObject
 		void deinit();
 		void setControllerUpdateInterval(int ms);
 		void resetControllerUpdateInterval();
+		void setEventCoalescingEnabled(bool enable);
+		// Reads controller input in a dedicated thread (enabled by default). Takes effect on next init().
+		void setInputThreadEnabled(bool enable);
+		void setInputThreadPriority(QThread::Priority priority);
 		void updateDevices();
 		void startDeviceReport(const QByteArray &uid) const;
 		void stopDeviceReport(const QByteArray &uid) const;
 		void toggleDeviceReport(const QByteArray &uid) const;
 		void requestDeviceReport(const QByteArray &uid) const;
+		void setAxisConditioning(const QByteArray &uid, uint16_t axis, const Devices::AxisConditioning &cfg) const;
+		void clearAxisConditioning(const QByteArray &uid) const;
+		// Passes a compiled report filter (or null to remove it) to the SDL API so filtered controls of its devices are dropped at the source.
+		// The filters are kept and passed on again if the SDL API is re-initialized.
+		void setEventFilter(const QByteArray &uid, const Devices::DeviceEventFilterPtr &filter);
+		void setEventQueueCapacity(std::size_t capacity);
 
 	Q_SIGNALS:
 		void deviceDiscovered(const QByteArray &uid);
@@ -76,7 +93,9 @@ class DeviceManager : public QObject
 		void deviceReportStarted(const QByteArray &uid);
 		void deviceReportStopped(const QByteArray &uid);
 		void deviceEvent(const Devices::DeviceEvent &ev);
-		void deviceEventPtr(const Devices::DeviceEvent *ev);
+		// Emitted with all the events from one update of a device, in the order they were received. The span is only valid
+		// for the duration of the emission, so this must only be connected with a direct connection.
+		void deviceEventBatch(InputDevice *dev, std::span<const Devices::EventRecord> events);
 		void deviceNameChanged(InputDevice *dev, const QString &name);
 		void deviceStateChanged(InputDevice *dev, Devices::DeviceState newState, Devices::DeviceState previousState = Devices::DeviceState::DS_Unknown);
 		void displayDetected(const Devices::DisplayInfo &displayInfo);
@@ -86,6 +105,7 @@ class DeviceManager : public QObject
 		void onPlatformDeviceDiscovered(const DeviceDescriptor &dd);
 		void onPlatformDeviceRemoved(const QByteArray &uid);
 		void onPlatformDeviceEvent(Devices::DeviceEvent *ev);
+		void onPlatformDeviceControlsDetected(const QByteArray &uid, const Devices::ControlCounts &counts);
 		void onPlatformDeviceReportToggled(const QByteArray &uid, bool started);
 		void onDevNameChanged(const QString &name);
 		void onDevStateChanged(Devices::DeviceState newState, Devices::DeviceState previousState);
@@ -0,0 +1,134 @@
+/*
+Device Input Plugin for Touch Portal
+Copyright Maxim Paperno; all rights reserved.
+
+This file may be used under the terms of the GNU
+General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+A copy of the GNU General Public License is available at <http://www.gnu.org/licenses/>.
+
+This project may also use 3rd-party Open Source software under the terms
+of their respective licenses. The copyright notice above does not apply
+to any 3rd-party components used within.
+*/
+
+#pragma once
+
+#include <QList>
+#include <QMutex>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "events.h"
+
+namespace Devices {
+
+// Report filter for one event type compiled to a bitset with a "pass" bit for each control index.
+// Indexes past the end of the bitset all share the `passOthers` result, so unfiltered types and wildcards need no bits at all.
+struct EventFilter
+{
+	bool passOthers {true};
+	uint32_t size {0};  // number of control indexes in `bits`
+	std::vector<uint64_t> bits {};
+
+	bool passes(uint16_t index) const {
+		return index < size ? (bits[index >> 6] >> (index & 63)) & 1 : passOthers;
+	}
+};
+
+// Compiled report filter of one device.
+struct DeviceEventFilter
+{
+	EventFilter types[EventType::EVENT_TYPE_ENUM_MAX];
+
+	bool passes(EventType type, uint16_t index) const { return types[type].passes(index); }
+	bool passes(const EventRecord &ev) const { return passes(ev.type, ev.index); }
+};
+
+using DeviceEventFilterPtr = std::shared_ptr<const DeviceEventFilter>;
+
+// Report filters of devices indexed by device handle, read by one input thread without any locking or reference counting.
+//
+// Changes are made to a copy of the current filter set which then replaces it with an atomic pointer swap (RCU). The replaced set is
+// kept until the reader has passed through a quiescent state after the swap, which it announces by bumping an epoch counter at the end
+// of each passes() call since it holds no references between calls (QSBR). Retired sets are deleted on later updates, so one
+// superseded set may linger until then. Updates may come from any thread and are serialized with a mutex which the reader never takes.
+class EventFilterRegistry
+{
+	public:
+		EventFilterRegistry() = default;
+		~EventFilterRegistry() {
+			delete m_current.load(std::memory_order_relaxed);
+			for (const Retired &r : std::as_const(m_retired))
+				delete r.set;
+		}
+
+		// Reader side; must only be called from one thread at a time. Events of devices without a filter always pass.
+		bool passes(DeviceHandle device, EventType type, uint16_t index)
+		{
+			const FilterSet *set = m_current.load(std::memory_order_seq_cst);
+			const bool ret = !set || device >= set->size() || !(*set)[device] || (*set)[device]->passes(type, index);
+			m_readerEpoch.fetch_add(1, std::memory_order_seq_cst);
+			return ret;
+		}
+
+		// Writer side. Sets or removes (with a null `filter`) the filter for one device.
+		void setFilter(DeviceHandle device, DeviceEventFilterPtr filter)
+		{
+			const QMutexLocker lock(&m_writeMutex);
+			const FilterSet *current = m_current.load(std::memory_order_relaxed);
+			if (!filter && (!current || device >= current->size() || !(*current)[device]))
+				return;
+			FilterSet *next = current ? new FilterSet(*current) : new FilterSet();
+			if (device >= next->size())
+				next->resize(device + 1);
+			(*next)[device] = std::move(filter);
+			publish(next);
+		}
+
+		// Writer side. Removes all filters.
+		void clear()
+		{
+			const QMutexLocker lock(&m_writeMutex);
+			if (m_current.load(std::memory_order_relaxed))
+				publish(nullptr);
+		}
+
+	private:
+		Q_DISABLE_COPY(EventFilterRegistry)
+
+		using FilterSet = std::vector<DeviceEventFilterPtr>;
+		struct Retired {
+			const FilterSet *set;
+			uint64_t epoch;  // reader epoch seen right after the set was replaced
+		};
+
+		void publish(const FilterSet *next)
+		{
+			const FilterSet *prev = m_current.exchange(next, std::memory_order_seq_cst);
+			const uint64_t epoch = m_readerEpoch.load(std::memory_order_seq_cst);
+			// anything retired before the reader's last quiescent state can no longer be in use
+			m_retired.removeIf([epoch](const Retired &r) {
+				if (r.epoch >= epoch)
+					return false;
+				delete r.set;
+				return true;
+			});
+			if (prev)
+				m_retired.append({ prev, epoch });
+		}
+
+		std::atomic<const FilterSet *> m_current { nullptr };
+		std::atomic_uint64_t m_readerEpoch { 0 };
+		QList<Retired> m_retired;
+		QMutex m_writeMutex;
+};
+
+}  // namespace Devices
@@ -0,0 +1,217 @@
+/*
+Device Input Plugin for Touch Portal
+Copyright Maxim Paperno; all rights reserved.
+
+This file may be used under the terms of the GNU
+General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+A copy of the GNU General Public License is available at <http://www.gnu.org/licenses/>.
+
+This project may also use 3rd-party Open Source software under the terms
+of their respective licenses. The copyright notice above does not apply
+to any 3rd-party components used within.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <memory>
+
+#include "events.h"
+
+#define DEVICE_EVENT_QUEUE_DEFAULT_CAPACITY  1024
+
+namespace Devices {
+
+// Bounded lock-free single-producer/single-consumer ring buffer.
+// push() must only be called by one (producer) thread at a time, and pop()/drain() by one (consumer) thread.
+// Capacity is rounded up to the next power of two.
+template <typename T>
+class SpscRing
+{
+		static_assert(std::is_trivially_copyable_v<T>, "SpscRing is meant for trivially copyable types");
+
+	public:
+		explicit SpscRing(std::size_t capacity = DEVICE_EVENT_QUEUE_DEFAULT_CAPACITY) :
+		  m_capacity(std::bit_ceil(std::max<std::size_t>(capacity, 2))),
+		  m_mask(m_capacity - 1),
+		  m_buffer(new T[m_capacity])
+		{}
+
+		std::size_t capacity() const { return m_capacity; }
+		// Number of queued items; this is only a snapshot when called while the other side is active.
+		std::size_t size() const { return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire); }
+		bool isEmpty() const { return !size(); }
+		// Total number of items rejected by push() because the ring was full.
+		uint64_t overflowCount() const { return m_overflows.load(std::memory_order_relaxed); }
+
+		// Producer side. Returns false, and increments the overflow count, if the ring is full.
+		bool push(const T &item)
+		{
+			const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+			if (tail - m_headCache >= m_capacity) {
+				m_headCache = m_head.load(std::memory_order_acquire);
+				if (tail - m_headCache >= m_capacity) {
+					m_overflows.fetch_add(1, std::memory_order_relaxed);
+					return false;
+				}
+			}
+			m_buffer[tail & m_mask] = item;
+			m_tail.store(tail + 1, std::memory_order_release);
+			return true;
+		}
+
+		// Consumer side. Returns false if the ring is empty.
+		bool pop(T &item)
+		{
+			const std::size_t head = m_head.load(std::memory_order_relaxed);
+			if (head == m_tailCache) {
+				m_tailCache = m_tail.load(std::memory_order_acquire);
+				if (head == m_tailCache)
+					return false;
+			}
+			item = m_buffer[head & m_mask];
+			m_head.store(head + 1, std::memory_order_release);
+			return true;
+		}
+
+		// Consumer side. Invokes `f(const T &)` for each currently queued item, up to `max` items if `max` is > 0.
+		// Returns the number of items consumed.
+		template <typename F>
+		std::size_t drain(F &&f, std::size_t max = 0)
+		{
+			std::size_t head = m_head.load(std::memory_order_relaxed);
+			m_tailCache = m_tail.load(std::memory_order_acquire);
+			std::size_t n = m_tailCache - head;
+			if (max && n > max)
+				n = max;
+			for (const std::size_t end = head + n; head != end; ++head) {
+				f(m_buffer[head & m_mask]);
+				m_head.store(head + 1, std::memory_order_release);
+			}
+			return n;
+		}
+
+	private:
+		const std::size_t m_capacity;
+		const std::size_t m_mask;
+		const std::unique_ptr<T[]> m_buffer;
+
+		alignas(64) std::atomic_size_t m_head { 0 };
+		std::size_t m_tailCache { 0 };  // consumer's view of m_tail
+		alignas(64) std::atomic_size_t m_tail { 0 };
+		std::size_t m_headCache { 0 };  // producer's view of m_head
+		alignas(64) std::atomic_uint64_t m_overflows { 0 };
+};
+
+// Device event queue with separate priority lanes for discrete (button, key, hat) and continuous (axis, motion, etc) events.
+// The consumer always drains all pending discrete events before continuous ones, and re-checks the discrete lane between
+// chunks of continuous events, so that button presses are not delayed behind a flood of axis movements. Event order is
+// preserved within each lane, and therefore per device within each lane.
+// The queue also tracks whether the consumer needs to be woken up. The producer only requests a wake-up when the consumer
+// is not already scheduled, which means one notification per batch of events instead of one per event.
+class EventQueue
+{
+	public:
+		enum Lane : uint8_t {
+			DiscreteLane,
+			ContinuousLane,
+
+			LaneCount
+		};
+
+		// Maximum number of continuous events processed before checking the discrete lane again.
+		static constexpr std::size_t ContinuousChunkSize = 64;
+
+		explicit EventQueue(std::size_t capacity = DEVICE_EVENT_QUEUE_DEFAULT_CAPACITY) :
+		  m_lanes { SpscRing<EventRecord>(capacity), SpscRing<EventRecord>(capacity) }
+		{}
+
+		static constexpr Lane laneForType(EventType type) {
+			switch (type) {
+				case EventType::Event_Button:
+				case EventType::Event_Key:
+				case EventType::Event_Hat:
+					return DiscreteLane;
+				default:
+					return ContinuousLane;
+			}
+		}
+
+		// Capacity of each lane.
+		std::size_t capacity() const { return m_lanes[0].capacity(); }
+		// Number of events queued in a lane; this is only a snapshot when called while the producer is active.
+		std::size_t depth(Lane lane) const { return m_lanes[lane].size(); }
+		std::size_t depth() const { return depth(DiscreteLane) + depth(ContinuousLane); }
+		// Highest depth of each lane seen by the consumer so far.
+		std::size_t peakDepth(Lane lane) const { return m_peakDepth[lane].load(std::memory_order_relaxed); }
+		// Total number of events dropped from a lane because it was full.
+		uint64_t overflowCount(Lane lane) const { return m_lanes[lane].overflowCount(); }
+		uint64_t overflowCount() const { return overflowCount(DiscreteLane) + overflowCount(ContinuousLane); }
+
+		// Producer side. Returns false if the event's lane is full. `wakeConsumer` is set to true if the consumer needs to be
+		// notified that new events are available.
+		bool enqueue(const EventRecord &ev, bool &wakeConsumer)
+		{
+			wakeConsumer = false;
+			if (!m_lanes[laneForType(ev.type)].push(ev))
+				return false;
+			wakeConsumer = !m_wakePending.exchange(true, std::memory_order_acq_rel);
+			return true;
+		}
+
+		// Consumer side. Processes all queued events with `f(const EventRecord &, Lane)`, discrete lane first, and returns
+		// the number processed. Discrete events which arrive while processing continuous ones are processed before the rest
+		// of the continuous events; any other events which arrive meanwhile will trigger a new wake-up.
+		template <typename F>
+		std::size_t consume(F &&f)
+		{
+			m_wakePending.exchange(false, std::memory_order_acq_rel);
+			updatePeakDepth(DiscreteLane);
+			std::size_t remaining = updatePeakDepth(ContinuousLane);
+			std::size_t total = 0;
+			while (true) {
+				total += m_lanes[DiscreteLane].drain([&f](const EventRecord &ev) { f(ev, DiscreteLane); });
+				if (!remaining)
+					break;
+				const std::size_t n = m_lanes[ContinuousLane].drain([&f](const EventRecord &ev) { f(ev, ContinuousLane); }, std::min(remaining, ContinuousChunkSize));
+				total += n;
+				remaining = n ? remaining - n : 0;
+			}
+			return total;
+		}
+
+		// Consumer side. Returns number of overflows in all lanes since the last time this method was called.
+		uint64_t takeNewOverflows()
+		{
+			const uint64_t total = overflowCount();
+			const uint64_t delta = total - m_reportedOverflows;
+			m_reportedOverflows = total;
+			return delta;
+		}
+
+	private:
+		// Returns the current depth of the lane.
+		std::size_t updatePeakDepth(Lane lane)
+		{
+			const std::size_t d = depth(lane);
+			if (d > m_peakDepth[lane].load(std::memory_order_relaxed))
+				m_peakDepth[lane].store(d, std::memory_order_relaxed);
+			return d;
+		}
+
+		SpscRing<EventRecord> m_lanes[LaneCount];
+		std::atomic_size_t m_peakDepth[LaneCount] {};
+		std::atomic_bool m_wakePending { false };
+		uint64_t m_reportedOverflows { 0 };
+};
+
+}
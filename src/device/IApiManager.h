@@ -24,9 +24,12 @@ to any 3rd-party components used within.
 
 // #include "events.h"
 // #include "devices.h"
+#include "EventFilter.h"
+#include "EventQueue.h"
 
 namespace Devices {
 class DeviceEvent;
+struct EventRecord;
 struct DisplayInfo;
 }
 struct DeviceDescriptor;
@@ -43,6 +46,17 @@ class IApiManager : public QObject
 
 		virtual inline QString getLastError() const { return m_lastError; }
 
+		// Queue of device events produced by this API; the consumer drains it when eventsAvailable() is emitted.
+		Devices::EventQueue *eventQueue() const { return m_eventQueue.get(); }
+		// Replaces the event queue with a new one of given capacity. Must only be used before init().
+		void setEventQueueCapacity(std::size_t capacity) {
+			if (capacity != m_eventQueue->capacity())
+				m_eventQueue.reset(new Devices::EventQueue(capacity));
+		}
+		// Sets or removes (with a null `filter`) the report filter of a device. Events from filtered out controls are dropped by the API
+		// before they're queued. Safe to call from any thread, and never blocks event input.
+		void setEventFilter(Devices::DeviceHandle device, Devices::DeviceEventFilterPtr filter) { m_eventFilters.setFilter(device, std::move(filter)); }
+
 	public Q_SLOTS:
 		// void setScanInterval(uint ms);
 		virtual void scanDevices() = 0;
@@ -52,13 +66,32 @@ class IApiManager : public QObject
 
 	Q_SIGNALS:
 		void deviceEvent(Devices::DeviceEvent *ev);
+		// Emitted when new events were added to an eventQueue() which the consumer isn't already scheduled to process.
+		void eventsAvailable();
 		void deviceDiscovered(const DeviceDescriptor &dd);
 		void deviceRemoved(const QByteArray &uid);
 		void deviceReportToggled(const QByteArray &uid, bool started);
+		// Emitted before deviceReportToggled() when a device is opened and the number of its controls is known.
+		void deviceControlsDetected(const QByteArray &uid, const Devices::ControlCounts &counts);
 		void displayDetected(const Devices::DisplayInfo &displayInfo);
 		void displayRemoved(short id);
 
 	protected:
+		// Producer side of the event queue; returns false if the queue overflowed.
+		bool queueEvent(const Devices::EventRecord &ev)
+		{
+			bool wake;
+			const bool ok = m_eventQueue->enqueue(ev, wake);
+			if (wake)
+				Q_EMIT eventsAvailable();
+			return ok;
+		}
+
+		// Must only be called from the thread producing events.
+		bool eventFilterPasses(Devices::DeviceHandle device, Devices::EventType type, uint16_t index) {
+			return m_eventFilters.passes(device, type, index);
+		}
+
 		void setLastError(const QString &msg) {
 			m_lastError = msg;
 		}
@@ -68,4 +101,6 @@ class IApiManager : public QObject
 		}
 
 		QString m_lastError;
+		std::unique_ptr<Devices::EventQueue> m_eventQueue { new Devices::EventQueue() };
+		Devices::EventFilterRegistry m_eventFilters;
 };
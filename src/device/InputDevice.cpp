@@ -52,6 +52,8 @@ InputDevice::InputDevice(const DeviceDescriptor &dd, QObject *parent) :
 {
 	Q_D(InputDevice);
 	d->descriptor = dd;
+	if (!d->descriptor.handle)
+		d->descriptor.handle = Devices::deviceHandleForUid(d->descriptor.uid);
 }
 
 InputDevice::InputDevice(DeviceDescriptor &&dd, QObject *parent) :
@@ -59,6 +61,8 @@ InputDevice::InputDevice(DeviceDescriptor &&dd, QObject *parent) :
 {
 	Q_D(InputDevice);
 	d->descriptor = std::move(dd);
+	if (!d->descriptor.handle)
+		d->descriptor.handle = Devices::deviceHandleForUid(d->descriptor.uid);
 }
 
 InputDevice::~InputDevice()
@@ -72,6 +76,7 @@ void InputDevice::setUid(const QByteArray &id)
 		return;
 
 	descriptor().uid = id;
+	descriptor().handle = Devices::deviceHandleForUid(id);
 	Q_EMIT uidChanged(id);
 }
 
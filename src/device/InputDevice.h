@@ -46,6 +46,8 @@ class InputDevice : public QObject
 		QByteArray uid() const { return descriptor().uid; }
 		void setUid(const QByteArray &id);
 
+		Devices::DeviceHandle handle() const { return descriptor().handle; }
+
 		QString name() const;
 		void setName(const QString &name);
 		void resetName() { setName(descriptorName()); }
@@ -55,6 +57,9 @@ class InputDevice : public QObject
 		uint8_t instance() const { return descriptor().instance; }
 		void setInstance(uint8_t number) { descriptor().instance = number; }
 
+		Devices::ControlCounts controlCounts() const { return descriptor().controls; }
+		void setControlCounts(const Devices::ControlCounts &counts) { descriptor().controls = counts; }
+
 		Devices::DeviceState state() const;
 		void setState(Devices::DeviceState newState);
 
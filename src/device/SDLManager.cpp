@@ -18,6 +18,7 @@ of their respective licenses. The copyright notice above does not apply
 to any 3rd-party components used within.
 */
 
+#include <QThread>
 #include <QTimer>
 
 #include "SDLManager.h"
@@ -125,6 +126,8 @@ static inline bool areGuidEqual(const SDL_GUID &l, const SDL_GUID &r) {
 }
 
 
+static bool SDLCALL SDLEventHander(void *context, SDL_Event *event);
+
 //
 // SDLManagerPrivate
 //
@@ -140,10 +143,179 @@ class SDLManagerPrivate
 	}
 
 	SDLManagerPrivate(SDLManager *q) :
+	  tickTim(new QTimer(q)),  // parented so that it moves to the input thread along with the manager
 	  q_ptr(q)
 	{
-		tickTim.setTimerType(Qt::PreciseTimer);
-		QObject::connect(&tickTim, &QTimer::timeout, SDL_PumpEvents);
+		tickTim->setTimerType(Qt::PreciseTimer);
+		QObject::connect(tickTim, &QTimer::timeout, tickTim, [this]() { pump(); });
+	}
+
+	// If called from a thread other than the one the manager lives in, queues `f` to run in the manager's thread and returns true.
+	template <typename F>
+	bool postToManagerThread(F &&f) const
+	{
+		if (QThread::currentThread() == q_ptr->thread())
+			return false;
+		QMetaObject::invokeMethod(q_ptr, std::forward<F>(f), Qt::QueuedConnection);
+		return true;
+	}
+
+	bool initSDL()
+	{
+		SDL_InitFlags sdlFlags = SDL_INIT_JOYSTICK /*| SDL_INIT_GAMEPAD*/;
+#if PLATFORM_SDL_INIT_VIDEO
+		sdlFlags |= SDL_INIT_VIDEO;
+#endif
+		if (!SDL_Init(sdlFlags)) {
+			qCCritical(lcSDL) << "Couldn't initialize SDL:" << SDL_GetError();
+			return false;
+		}
+		if (!SDL_AddEventWatch(::SDLEventHander, this)) {
+			qCCritical(lcSDL) << "Couldn't subscribe to SDL Events:" << SDL_GetError();
+			return false;
+		}
+
+		if (SDL_hid_init())
+			qCWarning(lcSDL) << "HID Init error:" << SDL_GetError();
+
+		SDL_SetEventEnabled(SDL_EVENT_JOYSTICK_BATTERY_UPDATED, false);
+		SDL_SetEventEnabled(SDL_EVENT_GAMEPAD_ADDED, false);
+		SDL_SetEventEnabled(SDL_EVENT_GAMEPAD_REMOVED, false);
+		SDL_SetEventEnabled(SDL_EVENT_GAMEPAD_AXIS_MOTION, false);
+		SDL_SetEventEnabled(SDL_EVENT_GAMEPAD_BUTTON_DOWN, false);
+		SDL_SetEventEnabled(SDL_EVENT_GAMEPAD_BUTTON_UP, false);
+		SDL_SetEventEnabled(SDL_EVENT_GAMEPAD_UPDATE_COMPLETE, false);
+		SDL_SetEventEnabled(SDL_EVENT_GAMEPAD_STEAM_HANDLE_UPDATED, false);
+
+		if (idleTimerInterval)
+			tickTim->start(idleTimerInterval);
+		q_ptr->clearLastError();
+		return true;
+	}
+
+	// Pumps SDL events, staging continuous events for coalescing if enabled, and flushes them afterwards.
+	void pump()
+	{
+		pumping = coalesceEvents.load(std::memory_order_relaxed);
+		SDL_PumpEvents();
+		pumping = false;
+		flushStagedEvents();
+	}
+
+	static inline uint64_t coalesceKey(const EventRecord &rec) {
+		return (uint64_t(rec.device) << 32) | (uint32_t(rec.type) << 16) | rec.index;
+	}
+
+	// Axis and ball events are only staged (and merged) during a pump cycle; everything else is just queued as-is.
+	bool queueOrStageEvent(const EventRecord &rec)
+	{
+		// Frames are assembled per device at the end of the pump when staging.
+		if (pumping && rec.isFrameMarker())
+			return true;
+
+		if (!pumping || (rec.type != EventType::Event_Axis && rec.type != EventType::Event_Scroll)) {
+			if (stagedEvents.isEmpty())
+				return q_ptr->queueEvent(rec);
+			stagedEvents.append(rec);  // preserve order relative to previously staged events
+			return true;
+		}
+
+		const auto it = stagedIndex.constFind(coalesceKey(rec));
+		if (it == stagedIndex.cend()) {
+			stagedIndex.insert(coalesceKey(rec), stagedEvents.size());
+			stagedEvents.append(rec);
+			return true;
+		}
+
+		EventRecord &staged = stagedEvents[it.value()];
+		staged.timestamp = rec.timestamp;
+		// steadyTime stays that of the first merged sample, so latency stats include the time the input waited here
+		if (rec.type == EventType::Event_Axis) {
+			staged.axis.value = rec.axis.value;
+		}
+		else {
+			// ball movement is relative so deltas are accumulated
+			staged.scroll.relX += rec.scroll.relX;
+			staged.scroll.relY += rec.scroll.relY;
+		}
+		coalescedEvents.fetch_add(1, std::memory_order_relaxed);
+		return true;
+	}
+
+	static inline uint32_t axisKey(DeviceHandle device, uint16_t index) {
+		return (uint32_t(device) << 16) | index;
+	}
+
+	// Returns conditioning settings for a specific axis of a device, or the device's default for all axes, or null if none.
+	const AxisConditioning *axisConditioningFor(DeviceHandle device, uint16_t index) const
+	{
+		const auto devIt = axisConditioning.constFind(device);
+		if (devIt == axisConditioning.cend())
+			return nullptr;
+		if (const auto it = devIt->constFind(index); it != devIt->cend())
+			return &it.value();
+		if (const auto it = devIt->constFind(0); it != devIt->cend())
+			return &it.value();
+		return nullptr;
+	}
+
+	// Applies any configured deadzones/quantization to the axis value of `rec` and returns false if the result should not be reported,
+	// either because it's the same as the last reported value or within the hysteresis range. Forced reports are never suppressed.
+	bool conditionAxisEvent(EventRecord &rec)
+	{
+		const AxisConditioning *cfg = axisConditioningFor(rec.device, rec.index);
+		if (cfg)
+			rec.axis.value = cfg->apply(rec.axis.value);
+
+		const uint32_t key = axisKey(rec.device, rec.index);
+		const auto last = lastAxisValues.find(key);
+		if (last == lastAxisValues.end()) {
+			lastAxisValues.insert(key, rec.axis.value);
+			return true;
+		}
+		if (!forcedReport) {
+			const float value = rec.axis.value;
+			if (value == *last || (cfg && cfg->hysteresis > 0.0f && std::abs(value - *last) < cfg->hysteresis && value != 0.0f && value != 0.5f && value != 1.0f)) {
+				suppressedAxisEvents.fetch_add(1, std::memory_order_relaxed);
+				return false;
+			}
+		}
+		*last = rec.axis.value;
+		return true;
+	}
+
+	void resetLastAxisValues(DeviceHandle device)
+	{
+		lastAxisValues.removeIf([device](QHash<uint32_t, float>::iterator it) { return (it.key() >> 16) == device; });
+	}
+
+	// Queues all staged events grouped by device and event queue lane, with the last event of each group marked as the end of that device's frame.
+	void flushStagedEvents()
+	{
+		if (stagedEvents.isEmpty())
+			return;
+		std::stable_sort(stagedEvents.begin(), stagedEvents.end(), [](const EventRecord &a, const EventRecord &b) {
+			return a.device < b.device || (a.device == b.device && EventQueue::laneForType(a.type) < EventQueue::laneForType(b.type));
+		});
+		for (qsizetype i = 0, e = stagedEvents.size(); i < e; ++i) {
+			EventRecord &rec = stagedEvents[i];
+			if (i == e - 1 || stagedEvents.at(i + 1).device != rec.device || EventQueue::laneForType(stagedEvents.at(i + 1).type) != EventQueue::laneForType(rec.type))
+				rec.flags |= EventRecord::FrameEnd;
+			q_ptr->queueEvent(rec);
+		}
+		stagedEvents.clear();
+		stagedIndex.clear();
+	}
+
+	void queueFrameEnd(const DeviceDescriptor &dd)
+	{
+		EventRecord rec {};
+		rec.timestamp = SDL_GetTicksNS();
+		rec.steadyTime = steadyClockNs();
+		rec.deviceType = dd.type.toInt();
+		rec.device = dd.handle;
+		rec.flags = EventRecord::FrameEnd;
+		q_ptr->queueEvent(rec);
 	}
 
 	DeviceDescriptor ddFromJoystickId(uint id) const
@@ -197,6 +369,7 @@ class SDLManagerPrivate
 
 		if (dd.uid.isEmpty())
 			dd.uid = dd.name.toLatin1() + '-' + QByteArray::number(dd.apiId, 16).toUpper();
+		dd.handle = deviceHandleForUid(dd.uid);
 
 		// if (jtype == SDL_JOYSTICK_TYPE_GAMEPAD) {
 		// 		if (const int playerIdx = SDL_GetGamepadPlayerIndexForID(id); playerIdx > -1)
@@ -211,44 +384,50 @@ class SDLManagerPrivate
 
 	bool SDLEventHander(SDL_Event *event)
 	{
-		uint instanceId = 0;
-		const DeviceDescriptor *dd = nullptr;
-		DeviceEvent *ev = nullptr;
-		// DeviceDescriptor ddd;
+		EventRecord rec {};
 
 		switch(event->type)
 		{
 			// Joystick
 
 			case SDL_EVENT_JOYSTICK_ADDED:
-				// dd =
 				addDiscoveredJoystick(event->jdevice.which);
-				break;
+				return true;
 
 			case SDL_EVENT_JOYSTICK_REMOVED:
-				removeDiscoveredJoystick(event->jdevice.which /*, &ddd*/);
-				// dd = &ddd;
-				break;
+				removeDiscoveredJoystick(event->jdevice.which);
+				return true;
 
 			case SDL_EVENT_JOYSTICK_AXIS_MOTION:
-				ev = new DeviceAxisEvent(event->common.timestamp, event->jaxis.axis + 1, std::clamp((event->jaxis.value - -32768) * (1.0f / 65535), 0.0f, 1.0f));
+				rec.type = EventType::Event_Axis;
+				rec.index = event->jaxis.axis + 1;
+				rec.axis.value = std::clamp((event->jaxis.value - -32768) * (1.0f / 65535), 0.0f, 1.0f);
 				break;
 
 			case SDL_EVENT_JOYSTICK_HAT_MOTION:
-				ev = new DeviceHatEvent(event->common.timestamp, event->jhat.hat + 1, event->jhat.value);
+				rec.type = EventType::Event_Hat;
+				rec.index = event->jhat.hat + 1;
+				rec.hat.value = event->jhat.value;
 				break;
 
 			case SDL_EVENT_JOYSTICK_BUTTON_DOWN:
 			case SDL_EVENT_JOYSTICK_BUTTON_UP:
-				ev = new DeviceButtonEvent(event->common.timestamp, event->jbutton.button + 1, event->jbutton.down);
+				rec.type = EventType::Event_Button;
+				rec.index = event->jbutton.button + 1;
+				rec.button.down = event->jbutton.down;
 				break;
 
 			case SDL_EVENT_JOYSTICK_BALL_MOTION:
-				ev = new DeviceScrollEvent(event->common.timestamp, event->jball.ball + 1, (float)event->jball.xrel, (float)event->jball.yrel);
+				rec.type = EventType::Event_Scroll;
+				rec.index = event->jball.ball + 1;
+				rec.scroll.relX = (float)event->jball.xrel;
+				rec.scroll.relY = (float)event->jball.yrel;
 				break;
 
 			case SDL_EVENT_JOYSTICK_UPDATE_COMPLETE:
-				return true;  // ignore
+				rec.type = EventType::Event_Generic;
+				rec.flags = EventRecord::FrameEnd;
+				break;
 
 			// Gamepad?
 			// case SDL_EVENT_GAMEPAD_ADDED:
@@ -262,26 +441,26 @@ class SDLManagerPrivate
 				return false;
 		}
 
-		if (!ev)
-			return true;
-
-		if (!instanceId)
-			instanceId = event->jdevice.which;
-
-		if (!dd && knownJoysticks.contains(instanceId))
-			dd = &knownJoysticks[instanceId];
-
-		if (dd && dd->type != DeviceType::DT_Unknown) {
-			ev->deviceType = dd->type;
-			ev->deviceUid = dd->uid;
-
-			// qCDebug(lcSDL) << "Dispatch Event:" << *ev << " || Device:" << instanceId << dd->name;
-			Q_EMIT q_ptr->deviceEvent(ev);
-			return true;
+		const auto dd = knownJoysticks.constFind(event->jdevice.which);
+		if (dd != knownJoysticks.cend() && dd->type != DeviceType::DT_Unknown) {
+			// Drop controls excluded by the device's report filter before doing anything else with the event.
+			if (!q_ptr->eventFilterPasses(dd->handle, rec.type, rec.index))
+				return true;
+			rec.timestamp = event->common.timestamp;
+			// Translate SDL's event time into the steady clock domain used for latency measurement.
+			const uint64_t sdlNow = SDL_GetTicksNS();
+			rec.steadyTime = steadyClockNs() - (sdlNow > rec.timestamp ? sdlNow - rec.timestamp : 0);
+			rec.deviceType = dd->type.toInt();
+			rec.device = dd->handle;
+
+			if (rec.type == EventType::Event_Axis && !conditionAxisEvent(rec))
+				return true;
+
+			// qCDebug(lcSDL) << "Dispatch Event:" << rec << " || Device:" << event->jdevice.which << dd->name;
+			return queueOrStageEvent(rec);
 		}
 
-		// qCDebug(lcSDL) << event->common.timestamp << "||" << LOG_HEX(event->type, 8) << " || Device:" << instanceId;
-		delete ev;
+		// qCDebug(lcSDL) << event->common.timestamp << "||" << LOG_HEX(event->type, 8) << " || Device:" << event->jdevice.which;
 		return false;
 	}
 
@@ -460,6 +639,7 @@ class SDLManagerPrivate
 			SDL_UpdateJoysticks();
 
 			event.jdevice.which = dd.apiId;
+			forcedReport = true;
 
 			int n = SDL_GetNumJoystickAxes(joy);
 			for (int i=0; i < n; ++i) {
@@ -512,6 +692,9 @@ class SDLManagerPrivate
 			}
 
 			// SDL_PumpEvents();
+			forcedReport = false;
+			if (!pumping)
+				queueFrameEnd(dd);
 
 			if (wasClosed)
 				SDL_CloseJoystick(joy);
@@ -549,7 +732,9 @@ class SDLManagerPrivate
 
 		shuttingDown = true;
 		disconnectAllDevicesQuietly();
-		tickTim.stop();
+		tickTim->stop();
+		flushStagedEvents();
+		qCInfo(lcSDL) << "Coalesced" << coalescedEvents.load() << "axis/ball event(s); suppressed" << suppressedAxisEvents.load() << "axis event(s).";
 		// SDL_hid_exit();
 		SDL_Quit();
 		sdlInit = false;
@@ -559,13 +744,25 @@ class SDLManagerPrivate
 	std::atomic_bool initializing { false };
 	std::atomic_bool shuttingDown { false };
 	std::atomic_uint_fast32_t numConnectedDevices { 0 };
+	std::atomic_bool coalesceEvents { true };
+	std::atomic_uint64_t coalescedEvents { 0 };
+	std::atomic_uint64_t suppressedAxisEvents { 0 };
+	bool pumping { false };
+	bool forcedReport { false };
 	int pumpTimerInterval { PLATFORM_SDL_PUMP_INTERVAL_MS };
 	int idleTimerInterval { PLATFORM_SDL_PUMP_IDLE_INTERVAL_MS };
 	QHash<uint, DeviceDescriptor> knownJoysticks;
 	QHash<QByteArray, uint> deviceUidMap;
 	QList<DisplayInfo> screenInfoList;
+	QList<EventRecord> stagedEvents;
+	QHash<uint64_t, qsizetype> stagedIndex;
+	QHash<DeviceHandle, QHash<uint16_t, AxisConditioning>> axisConditioning;  // axis index 0 is the default for all axes of a device
+	QHash<uint32_t, float> lastAxisValues;  // last reported values by axisKey()
 	QString lastError;
-	QTimer tickTim;
+	QTimer *tickTim;
+	QThread *inputThread = nullptr;
+	QThread::Priority inputThreadPriority { QThread::NormalPriority };
+	bool useInputThread { false };
 	SDLManager * const q_ptr;
 };
 
@@ -615,44 +812,45 @@ bool SDLManager::init()
 
 	d->initializing = true;
 
-	SDL_InitFlags sdlFlags = SDL_INIT_JOYSTICK /*| SDL_INIT_GAMEPAD*/;
-#if PLATFORM_SDL_INIT_VIDEO
-	sdlFlags |= SDL_INIT_VIDEO;
-#endif
-	if (!SDL_Init(sdlFlags)) {
-		qCCritical(lcSDL) << "Couldn't initialize SDL:" << SDL_GetError();
-	}
-	else if (!SDL_AddEventWatch(SDLEventHander, d)) {
-		qCCritical(lcSDL) << "Couldn't subscribe to SDL Events:" << SDL_GetError();
+	if (d->useInputThread && !d->inputThread) {
+		d->inputThread = new QThread();
+		d->inputThread->setObjectName("SDLInput");
+		d->inputThread->start(d->inputThreadPriority);
+		moveToThread(d->inputThread);
+		qCDebug(lcSDL) << "Started SDL input thread with priority" << d->inputThreadPriority;
 	}
-	else {
-		if (SDL_hid_init())
-			qCWarning(lcSDL) << "HID Init error:" << SDL_GetError();
 
-		SDL_SetEventEnabled(SDL_EVENT_JOYSTICK_UPDATE_COMPLETE, false);
-		SDL_SetEventEnabled(SDL_EVENT_JOYSTICK_BATTERY_UPDATED, false);
-		SDL_SetEventEnabled(SDL_EVENT_GAMEPAD_ADDED, false);
-		SDL_SetEventEnabled(SDL_EVENT_GAMEPAD_REMOVED, false);
-		SDL_SetEventEnabled(SDL_EVENT_GAMEPAD_AXIS_MOTION, false);
-		SDL_SetEventEnabled(SDL_EVENT_GAMEPAD_BUTTON_DOWN, false);
-		SDL_SetEventEnabled(SDL_EVENT_GAMEPAD_BUTTON_UP, false);
-		SDL_SetEventEnabled(SDL_EVENT_GAMEPAD_UPDATE_COMPLETE, false);
-		SDL_SetEventEnabled(SDL_EVENT_GAMEPAD_STEAM_HANDLE_UPDATED, false);
-
-		if (d->idleTimerInterval)
-			d->tickTim.start(d->idleTimerInterval);
-		clearLastError();
-		d->sdlInit = true;
-	}
+	bool ok = false;
+	if (d->inputThread)
+		QMetaObject::invokeMethod(this, [d, &ok]() { ok = d->initSDL(); }, Qt::BlockingQueuedConnection);
+	else
+		ok = d->initSDL();
 
+	d->sdlInit = ok;
 	d->initializing = false;
-	return d->sdlInit;
+	return ok;
 }
 
 
 void SDLManager::deinit()
 {
-	d_ptr->closeSDL();
+	Q_D(SDLManager);
+	if (!d->inputThread) {
+		d->closeSDL();
+		return;
+	}
+
+	// Shut down SDL in the input thread and hand this object back to the calling thread before stopping the input thread.
+	QThread *callerThread = QThread::currentThread();
+	QMetaObject::invokeMethod(this, [this, d, callerThread]() {
+		d->closeSDL();
+		moveToThread(callerThread);
+	}, Qt::BlockingQueuedConnection);
+	d->inputThread->quit();
+	d->inputThread->wait();
+	delete d->inputThread;
+	d->inputThread = nullptr;
+	qCDebug(lcSDL) << "SDL input thread stopped.";
 }
 
 QString SDLManager::getLastError() const
@@ -674,6 +872,8 @@ int SDLManager::defaultActiveScanInterval() const {
 void SDLManager::setActiveScanInterval(int ms)
 {
 	Q_D(SDLManager);
+	if (d->postToManagerThread([=, this]() { setActiveScanInterval(ms); }))
+		return;
 	if (ms == d->pumpTimerInterval)
 		return;
 
@@ -683,9 +883,9 @@ void SDLManager::setActiveScanInterval(int ms)
 		return;
 
 	if (ms <= 0)
-		d->tickTim.stop();
+		d->tickTim->stop();
 	else
-		d->tickTim.start(d->pumpTimerInterval);
+		d->tickTim->start(d->pumpTimerInterval);
 }
 
 int SDLManager::idleScanInterval() const {
@@ -696,9 +896,80 @@ int SDLManager::defaultIdleScanInterval() const {
 	return PLATFORM_SDL_PUMP_IDLE_INTERVAL_MS;
 }
 
+bool SDLManager::eventCoalescingEnabled() const {
+	return d_ptr->coalesceEvents;
+}
+
+uint64_t SDLManager::coalescedEventCount() const {
+	return d_ptr->coalescedEvents;
+}
+
+void SDLManager::setEventCoalescingEnabled(bool enable)
+{
+	Q_D(SDLManager);
+	if (d->coalesceEvents == enable)
+		return;
+	d->coalesceEvents = enable;
+	qCDebug(lcSDL) << "Axis/ball event coalescing enabled:" << enable;
+}
+
+void SDLManager::setAxisConditioning(Devices::DeviceHandle device, uint16_t axis, const Devices::AxisConditioning &cfg)
+{
+	Q_D(SDLManager);
+	if (d->postToManagerThread([=, this]() { setAxisConditioning(device, axis, cfg); }))
+		return;
+	if (cfg.isNull()) {
+		if (const auto it = d->axisConditioning.find(device); it != d->axisConditioning.end()) {
+			it->remove(axis);
+			if (it->isEmpty())
+				d->axisConditioning.erase(it);
+		}
+	}
+	else {
+		d->axisConditioning[device].insert(axis, cfg.bounded());
+	}
+	// next value from this device will be reported regardless of the previous one
+	d->resetLastAxisValues(device);
+}
+
+void SDLManager::clearAxisConditioning(Devices::DeviceHandle device)
+{
+	Q_D(SDLManager);
+	if (d->postToManagerThread([=, this]() { clearAxisConditioning(device); }))
+		return;
+	d->axisConditioning.remove(device);
+	d->resetLastAxisValues(device);
+}
+
+void SDLManager::setUseInputThread(bool enable)
+{
+	Q_D(SDLManager);
+	if (d->sdlInit || d->initializing) {
+		qCWarning(lcSDL) << "Input thread usage can only be changed before initialization.";
+		return;
+	}
+	d->useInputThread = enable;
+}
+
+bool SDLManager::usesInputThread() const {
+	return d_ptr->useInputThread;
+}
+
+void SDLManager::setInputThreadPriority(QThread::Priority priority)
+{
+	Q_D(SDLManager);
+	d->inputThreadPriority = priority;
+	if (d->inputThread && d->inputThread->isRunning()) {
+		d->inputThread->setPriority(priority);
+		qCDebug(lcSDL) << "Set SDL input thread priority to" << priority;
+	}
+}
+
 void SDLManager::setIdleScanInterval(int ms)
 {
 	Q_D(SDLManager);
+	if (d->postToManagerThread([=, this]() { setIdleScanInterval(ms); }))
+		return;
 	if (ms == d->idleTimerInterval)
 		return;
 
@@ -708,28 +979,32 @@ void SDLManager::setIdleScanInterval(int ms)
 		return;
 
 	if (ms <= 0)
-		d->tickTim.stop();
+		d->tickTim->stop();
 	else
-		d->tickTim.start(d->idleTimerInterval);
+		d->tickTim->start(d->idleTimerInterval);
 }
 
 void SDLManager::scanDevices()
 {
 	Q_D(SDLManager);
+	if (d->postToManagerThread([=, this]() { scanDevices(); }))
+		return;
 	if (!d->sdlInit)
 		return;
 
 	SDL_UpdateJoysticks();
-	SDL_PumpEvents();
+	d->pump();
 	d->checkForRemovedDevices();
 	d->knownJoysticks.clear();
 	d->discoverDevices();
-	SDL_PumpEvents();
+	d->pump();
 }
 
 void SDLManager::connectDevice(const QByteArray &uid)
 {
 	Q_D(SDLManager);
+	if (d->postToManagerThread([=, this]() { connectDevice(uid); }))
+		return;
 	const DeviceDescriptor *dd = nullptr;
 	if (!d->tryGetDevice(uid, dd)) {
 		setLastError(u"Device not found for UID %1"_s.arg(uid));
@@ -743,9 +1018,16 @@ void SDLManager::connectDevice(const QByteArray &uid)
 			if (SDL_GetJoystickFromID(dd->apiId))
 				break; // already opened
 
-			if (SDL_OpenJoystick(dd->apiId)) {
+			if (SDL_Joystick *joy = SDL_OpenJoystick(dd->apiId)) {
 				++d->numConnectedDevices;
 				qCDebug(lcSDL) << "Opened Joystick Instance ID:" << dd->apiId << dd->name << dd->uid;
+				const auto count = [](int n) { return uint16_t(qMax(n, 0)); };
+				Q_EMIT deviceControlsDetected(uid, {
+					count(SDL_GetNumJoystickAxes(joy)),
+					count(SDL_GetNumJoystickButtons(joy)),
+					count(SDL_GetNumJoystickHats(joy)),
+					count(SDL_GetNumJoystickBalls(joy)),
+				});
 				break;
 			}
 			setLastError(u"Can't open Device Instance ID: %1; Name: %2; SDL Error: %3"_s.arg(Devices::deviceTypeName(dd->type), dd->name, SDL_GetError()));
@@ -759,7 +1041,7 @@ void SDLManager::connectDevice(const QByteArray &uid)
 	}
 
 	if (!prevConnected && d->numConnectedDevices > 0 && d->pumpTimerInterval > 0) {
-		d->tickTim.start(d->pumpTimerInterval);
+		d->tickTim->start(d->pumpTimerInterval);
 		qCDebug(lcSDL) << "First active device connection, starting SDL event loop at full speed now.";
 	}
 
@@ -770,6 +1052,8 @@ void SDLManager::connectDevice(const QByteArray &uid)
 void SDLManager::disconnectDevice(const QByteArray &uid)
 {
 	Q_D(SDLManager);
+	if (d->postToManagerThread([=, this]() { disconnectDevice(uid); }))
+		return;
 
 	const DeviceDescriptor *dd = nullptr;
 	if (!d->tryGetDevice(uid, dd))
@@ -780,6 +1064,7 @@ void SDLManager::disconnectDevice(const QByteArray &uid)
 		case DeviceType::DT_Controller:
 			if (SDL_Joystick *joy = SDL_GetJoystickFromID(dd->apiId)) {
 				SDL_CloseJoystick(joy);
+				d->resetLastAxisValues(dd->handle);
 				if (d->numConnectedDevices > 0)
 					--d->numConnectedDevices;
 				qCDebug(lcSDL) << "Controller device disconnected:" << dd->apiId << Devices::deviceTypeName(dd->type) << dd->name << dd->uid;
@@ -798,9 +1083,9 @@ void SDLManager::disconnectDevice(const QByteArray &uid)
 
 	if (!d->numConnectedDevices) {
 		if (d->idleTimerInterval > 0)
-			d->tickTim.start(d->idleTimerInterval);
+			d->tickTim->start(d->idleTimerInterval);
 		else
-			d->tickTim.stop();
+			d->tickTim->stop();
 		qCDebug(lcSDL) << "No more connected devices, slowing SDL event loop now.";
 	}
 }
@@ -808,6 +1093,8 @@ void SDLManager::disconnectDevice(const QByteArray &uid)
 void SDLManager::sendDeviceReport(const QByteArray &uid)
 {
 	Q_D(SDLManager);
+	if (d->postToManagerThread([=, this]() { sendDeviceReport(uid); }))
+		return;
 	if (uid == DI_SYSTEM_SCREEN_UID) {
 		d->enumerateDisplays();
 		return;
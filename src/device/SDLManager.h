@@ -21,6 +21,7 @@ to any 3rd-party components used within.
 #pragma once
 
 #include <QObject>
+#include <QThread>
 
 // #include "events.h"
 // #include "devices.h"
@@ -48,10 +49,25 @@ class SDLManager : public IApiManager
 		int defaultActiveScanInterval() const;
 		int idleScanInterval() const;
 		int defaultIdleScanInterval() const;
+		// Run the SDL event watch and pump in a dedicated thread instead of the one this manager was created in.
+		// Must be set before init(). The manager must not have a parent object if the input thread is used.
+		void setUseInputThread(bool enable);
+		bool usesInputThread() const;
+		bool eventCoalescingEnabled() const;
+		// Total number of axis/ball events merged into a later event from the same control.
+		uint64_t coalescedEventCount() const;
 
 	public Q_SLOTS:
 		void setActiveScanInterval(int ms);
 		void setIdleScanInterval(int ms);
+		// When enabled, multiple axis or ball events from the same device control received during one SDL event pump cycle
+		// are merged into one event with the latest value (or the sum of relative ball movements). Enabled by default.
+		void setEventCoalescingEnabled(bool enable);
+		void setInputThreadPriority(QThread::Priority priority);
+		// Sets deadzone/hysteresis/quantization for one axis (1-based index) of a device, or all its axes if `axis` is 0.
+		// Settings for specific axes take precedence over the default. A null `cfg` removes the settings for that axis index.
+		void setAxisConditioning(Devices::DeviceHandle device, uint16_t axis, const Devices::AxisConditioning &cfg);
+		void clearAxisConditioning(Devices::DeviceHandle device);
 
 		void scanDevices() override;
 		void connectDevice(const QByteArray &uid) override;
@@ -21,6 +21,8 @@ to any 3rd-party components used within.
 #pragma once
 
 #include <QtCore>
+#include <algorithm>
+#include <cmath>
 #include <cstdint>
 
 #define DI_SYSTEM_KEYBOARD_ID  1
@@ -129,6 +131,47 @@ enum MouseButton : uint8_t
 };
 Q_ENUM_NS(MouseButton)
 
+// Small process-wide device identifier, used in event records in place of the (potentially long) device UID string.
+// Zero is invalid.
+using DeviceHandle = uint16_t;
+
+// Source-side conditioning of controller axis values, applied before an axis event is reported.
+// All values are in the normalized 0.0 - 1.0 axis range.
+struct AxisConditioning
+{
+	float centerDeadzone {0.0f};  // total width of dead zone around the axis center; max. 0.9
+	float edgeDeadzone {0.0f};    // width of dead zone at each end of the axis range; max. 0.45
+	float hysteresis {0.0f};      // minimum change from the last reported value required to report a new one
+	uint16_t steps {0};           // quantize values to this many steps; 0 to disable
+
+	bool isNull() const { return centerDeadzone <= 0.0f && edgeDeadzone <= 0.0f && hysteresis <= 0.0f && !steps; }
+
+	// Returns a copy with all values clamped to their valid ranges.
+	AxisConditioning bounded() const {
+		return { std::clamp(centerDeadzone, 0.0f, 0.9f), std::clamp(edgeDeadzone, 0.0f, 0.45f), std::clamp(hysteresis, 0.0f, 1.0f), steps };
+	}
+
+	// Applies deadzones and quantization to a normalized axis value. Values outside the deadzones are re-scaled to cover the full range.
+	float apply(float value) const
+	{
+		if (edgeDeadzone > 0.0f)
+			value = std::clamp((value - edgeDeadzone) / (1.0f - 2.0f * edgeDeadzone), 0.0f, 1.0f);
+		if (centerDeadzone > 0.0f) {
+			const float half = centerDeadzone * 0.5f;
+			const float offset = value - 0.5f;
+			if (std::abs(offset) <= half)
+				value = 0.5f;
+			else
+				value = 0.5f + (offset - std::copysign(half, offset)) * (0.5f / (0.5f - half));
+		}
+		if (steps)
+			value = std::round(value * steps) / steps;
+		return value;
+	}
+
+	bool operator==(const AxisConditioning &) const = default;
+};
+
 struct DisplayInfo
 {
 	short index {0};
@@ -138,6 +181,15 @@ struct DisplayInfo
 	std::string name {};
 };
 
+// Number of controls of each type which a device has; only known once the device has been opened for reporting.
+struct ControlCounts
+{
+	uint16_t axes {0};
+	uint16_t buttons {0};
+	uint16_t hats {0};
+	uint16_t balls {0};
+};
+
 // These are only used by the core Plugin to parse key modifier bitfields;
 // They're here to avoid needing to include SDL directly, but should
 // match the corresponding SDL macros.
@@ -219,7 +271,7 @@ static inline constexpr bool isToggleKey(uint scancode) {
 #endif
 }
 
-static QHash<DeviceTypes, QString> deviceTypeNames()
+static const QHash<DeviceTypes, QString> &deviceTypeNames()
 {
 	static const QHash<DeviceTypes, QString> map {
 		{  DeviceType::DT_Unknown,      tr("Unknown", "device type") },
@@ -270,3 +322,4 @@ static Devices::DeviceTypes deviceTypeNameToType(QStringView name)
 }
 
 Q_DECLARE_METATYPE(Devices::DisplayInfo)
+Q_DECLARE_METATYPE(Devices::ControlCounts)
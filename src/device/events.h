@@ -20,6 +20,12 @@ to any 3rd-party components used within.
 
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <new>
+#include <thread>
+
 #include "devices.h"
 #include "logging.h"
 
@@ -27,6 +33,226 @@ class InputDevice;
 
 namespace Devices {
 
+struct EventPoolStats
+{
+	uint64_t hits;    //< allocations served from the free list
+	uint64_t misses;  //< allocations which required a new slab (or a size mismatch fallback to global new)
+	uint64_t slabs;   //< number of slabs allocated so far
+};
+
+// Per-type free-list allocator for heap-allocated event objects. Memory is carved from slabs of `SlabSize` chunks
+// and returned to the free list on delete, so a steady flow of events does not touch the global heap.
+// Events are typically created on the device API thread and deleted on the Plugin thread, so the free list is
+// guarded with a spin lock (critical sections are just a couple of pointer swaps).
+// Slabs are never released; the pool instance is intentionally leaked to avoid static destruction order issues.
+template <typename T, std::size_t SlabSize = 64>
+class EventPool
+{
+	public:
+		static EventPool &instance() {
+			static EventPool * const pool = new EventPool();
+			return *pool;
+		}
+
+		void *allocate(std::size_t size)
+		{
+			// A derived type without its own pool would end up here with a different size.
+			if (size != sizeof(T)) {
+				m_misses.fetch_add(1, std::memory_order_relaxed);
+				return ::operator new(size);
+			}
+			lock();
+			if (!m_free)
+				addSlab();
+			else
+				m_hits.fetch_add(1, std::memory_order_relaxed);
+			Chunk *c = m_free;
+			m_free = c->next;
+			unlock();
+			return c;
+		}
+
+		void release(void *p, std::size_t size)
+		{
+			if (!p)
+				return;
+			if (size != sizeof(T)) {
+				::operator delete(p);
+				return;
+			}
+			Chunk *c = static_cast<Chunk *>(p);
+			lock();
+			c->next = m_free;
+			m_free = c;
+			unlock();
+		}
+
+		EventPoolStats stats() const {
+			return { m_hits.load(std::memory_order_relaxed), m_misses.load(std::memory_order_relaxed), m_slabs.load(std::memory_order_relaxed) };
+		}
+
+	private:
+		union Chunk {
+			Chunk *next;
+			alignas(T) unsigned char storage[sizeof(T)];
+		};
+
+		EventPool() = default;
+		Q_DISABLE_COPY_MOVE(EventPool)
+
+		inline void lock() {
+			while (m_lock.test_and_set(std::memory_order_acquire))
+				std::this_thread::yield();
+		}
+		inline void unlock() { m_lock.clear(std::memory_order_release); }
+
+		// must be called with lock held
+		void addSlab()
+		{
+			Chunk *slab = new Chunk[SlabSize];
+			for (std::size_t i = 0; i < SlabSize - 1; ++i)
+				slab[i].next = &slab[i + 1];
+			slab[SlabSize - 1].next = m_free;
+			m_free = slab;
+			m_misses.fetch_add(1, std::memory_order_relaxed);
+			m_slabs.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		Chunk *m_free = nullptr;
+		std::atomic_flag m_lock = ATOMIC_FLAG_INIT;
+		std::atomic_uint64_t m_hits { 0 };
+		std::atomic_uint64_t m_misses { 0 };
+		std::atomic_uint64_t m_slabs { 0 };
+};
+
+// Routes class-specific new/delete for an event type through its EventPool. Since DeviceEvent has a virtual destructor,
+// deleting through a base pointer still returns the memory to the pool of the most-derived type.
+#define DEVICE_EVENT_POOLED(T) \
+	static void *operator new(std::size_t size) { return Devices::EventPool<T>::instance().allocate(size); } \
+	static void operator delete(void *p, std::size_t size) { Devices::EventPool<T>::instance().release(p, size); }
+
+// Key name/text buffer sizes, including the terminating null, chosen to keep a record within 128 bytes.
+// SDL scancode names are ASCII and under 20 characters; text from the OS keyboard layout is usually 1-2 characters.
+// Anything longer (eg. localized key names) is truncated on a UTF-8 character boundary.
+#define EVENT_RECORD_KEY_NAME_SIZE  40
+#define EVENT_RECORD_KEY_TEXT_SIZE  40
+
+// Current monotonic time in nanoseconds, used for event latency measurements.
+static inline uint64_t steadyClockNs() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Compact, trivially copyable representation of any device input event. Records can be stored in arrays and
+// passed through queues by value; the device is identified by its DeviceHandle instead of the UID string.
+// The payload union member to use is determined by `type`.
+struct EventRecord
+{
+		struct AxisData {
+			float value;
+		};
+		struct HatData {
+			int32_t value;
+		};
+		struct ButtonData {
+			float x;
+			float y;
+			bool down;
+		};
+		// Motion and Scroll
+		struct PositionData {
+			float x;
+			float y;
+			float relX;
+			float relY;
+			uint32_t buttons;
+		};
+		struct KeyData {
+			uint32_t modifiers;
+			uint32_t sdlKey;
+			uint32_t nativeKey;
+			uint32_t nativeScanCode;
+			bool down;
+			bool repeat;
+			char name[EVENT_RECORD_KEY_NAME_SIZE];  //< UTF-8, null-terminated (possibly truncated)
+			char text[EVENT_RECORD_KEY_TEXT_SIZE];  //< UTF-8, null-terminated (possibly truncated)
+		};
+
+		enum Flag : uint8_t {
+			NoFlags  = 0x00,
+			FrameEnd = 0x01,  //< last record of one device update; a record of Event_Generic type with this flag only marks the end of a frame
+		};
+
+		uint64_t timestamp;
+		uint64_t steadyTime;  //< time the event was received from the OS, as steadyClockNs(); may be 0 if unknown
+		uint32_t deviceType;  //< DeviceTypes flags value
+		DeviceHandle device;
+		uint16_t index;       //< index of originating control, or key scan code
+		EventType type;
+		uint8_t flags;        //< Flag values
+		union {
+			AxisData axis;
+			HatData hat;
+			ButtonData button;
+			PositionData motion;
+			PositionData scroll;
+			KeyData key;
+		};
+
+		inline DeviceTypes devType() const { return DeviceTypes::fromInt(deviceType); }
+		inline bool isFrameEnd() const { return flags & FrameEnd; }
+		inline bool isFrameMarker() const { return type == EventType::Event_Generic && isFrameEnd(); }
+		inline QString keyName() const { return QString::fromUtf8(key.name); }
+		inline QString keyText() const { return QString::fromUtf8(key.text); }
+
+		// Copies UTF-8 string to fixed size key name/text buffer, truncating on a character boundary if needed.
+		template <std::size_t N>
+		static void copyKeyString(char (&dest)[N], const QString &src)
+		{
+			const QByteArray utf8 = src.toUtf8();
+			qsizetype len = std::min<qsizetype>(utf8.size(), N - 1);
+			// don't split a multi-byte sequence
+			while (len > 0 && len < utf8.size() && (utf8.at(len) & 0xC0) == 0x80)
+				--len;
+			memcpy(dest, utf8.constData(), len);
+			dest[len] = '\0';
+		}
+
+		friend QDebug operator <<(QDebug dbg, const EventRecord &ev) {
+			QDebugStateSaver saver(dbg);
+			dbg.nospace() << '{'
+				<< ev.timestamp << DBG_SEP << ev.type << DBG_SEP << Devices::deviceTypeName(ev.devType()) << DBG_SEP
+				<< ev.device << DBG_SEP << LOG_HEX4(ev.index) << " | ";
+			switch (ev.type) {
+				case EventType::Event_Axis:
+					dbg << ev.axis.value;
+					break;
+				case EventType::Event_Hat:
+					dbg << ev.hat.value;
+					break;
+				case EventType::Event_Button:
+					dbg << ev.button.x << DBG_SEP << ev.button.y << DBG_SEP << ev.button.down;
+					break;
+				case EventType::Event_Motion:
+				case EventType::Event_Scroll:
+					dbg << ev.motion.x << DBG_SEP << ev.motion.y << DBG_SEP << ev.motion.relX << DBG_SEP << ev.motion.relY << DBG_SEP << ev.motion.buttons;
+					break;
+				case EventType::Event_Key:
+					dbg << LOG_HEX4(ev.key.sdlKey) << DBG_SEP << LOG_HEX4(ev.key.nativeKey) << DBG_SEP << LOG_HEX4(ev.key.nativeScanCode) << DBG_SEP
+					    << LOG_HEX4(ev.key.modifiers) << DBG_SEP << ev.key.down << DBG_SEP << ev.key.repeat << DBG_SEP << ev.key.name << DBG_SEP << ev.key.text;
+					break;
+				default:
+					break;
+			}
+			return dbg << '}';
+		}
+};
+static_assert(std::is_trivially_copyable_v<EventRecord>, "EventRecord must be trivially copyable");
+static_assert(sizeof(EventRecord) <= 128, "EventRecord should fit into two cache lines");
+
+struct DeviceEvent;
+// Owning handle for heap-allocated events; releasing it recycles the event's memory back into its type's pool.
+using DeviceEventPtr = std::unique_ptr<const DeviceEvent>;
+
 struct DeviceEvent
 {
 		DeviceEvent() { }
@@ -41,6 +267,16 @@ struct DeviceEvent
 
 		virtual DeviceEvent *clone() const { return new DeviceEvent(*this); };
 
+		DEVICE_EVENT_POOLED(DeviceEvent)
+
+		// Fills in a compact record from this event. The device handle isn't known here and needs to be set by the caller.
+		virtual void toRecord(EventRecord &rec) const {
+			rec.timestamp = timestamp;
+			rec.deviceType = deviceType.toInt();
+			rec.index = uint16_t(index);
+			rec.type = type;
+		}
+
 		const EventType type { EventType::Event_Generic };
 		uint64_t timestamp { 0 };
 		DeviceTypes deviceType { DeviceType::DT_Unknown };
@@ -75,6 +311,12 @@ struct DeviceAxisEvent : public DeviceEvent
 		// 	value{other.value} {}
 
 		DeviceAxisEvent *clone() const override { return new DeviceAxisEvent(*this); }
+		DEVICE_EVENT_POOLED(DeviceAxisEvent)
+
+		void toRecord(EventRecord &rec) const override {
+			DeviceEvent::toRecord(rec);
+			rec.axis.value = value;
+		}
 
 		// uint8_t index;
 		float value;
@@ -98,6 +340,12 @@ struct DeviceHatEvent : public DeviceEvent
 		// 	value{other.value} {}
 
 		DeviceHatEvent *clone() const override { return new DeviceHatEvent(*this); }
+		DEVICE_EVENT_POOLED(DeviceHatEvent)
+
+		void toRecord(EventRecord &rec) const override {
+			DeviceEvent::toRecord(rec);
+			rec.hat.value = value;
+		}
 
 		// uint8_t index;
 		int value;
@@ -129,6 +377,19 @@ struct DeviceKeyEvent : public DeviceEvent
 		//   name(other.name), text(other.text) {}
 
 		DeviceKeyEvent *clone() const override { return new DeviceKeyEvent(*this); }
+		DEVICE_EVENT_POOLED(DeviceKeyEvent)
+
+		void toRecord(EventRecord &rec) const override {
+			DeviceEvent::toRecord(rec);
+			rec.key.modifiers = modifiers;
+			rec.key.sdlKey = sdlKey;
+			rec.key.nativeKey = nativeKey;
+			rec.key.nativeScanCode = nativeScanCode;
+			rec.key.down = down;
+			rec.key.repeat = repeat;
+			EventRecord::copyKeyString(rec.key.name, name);
+			EventRecord::copyKeyString(rec.key.text, text);
+		}
 
 		inline uint key() const { return index; }
 		inline uint scancode() const { return index; }
@@ -189,6 +450,14 @@ struct DeviceScrollEvent : public DevicePositionEvent
 		// DeviceScrollEvent(const DeviceScrollEvent &other) : DevicePositionEvent(other),
 		//   relX{other.relX}, relY{other.relY} {}
 
+		DeviceScrollEvent *clone() const override { return new DeviceScrollEvent(*this); }
+		DEVICE_EVENT_POOLED(DeviceScrollEvent)
+
+		void toRecord(EventRecord &rec) const override {
+			DeviceEvent::toRecord(rec);
+			rec.scroll = { x, y, relX, relY, 0 };
+		}
+
 		float relX;
 		float relY;
 
@@ -214,6 +483,12 @@ struct DeviceButtonEvent : public DevicePositionEvent
 		// 	down{other.down} {}
 
 		DeviceButtonEvent *clone() const override { return new DeviceButtonEvent(*this); }
+		DEVICE_EVENT_POOLED(DeviceButtonEvent)
+
+		void toRecord(EventRecord &rec) const override {
+			DeviceEvent::toRecord(rec);
+			rec.button = { x, y, down };
+		}
 
 		bool down;
 
@@ -241,6 +516,12 @@ struct DeviceMotionEvent : public DevicePositionEvent
 		// 	relX{other.relX}, relY{other.relY}, buttons{other.buttons} {}
 
 		DeviceMotionEvent *clone() const override { return new DeviceMotionEvent(*this); }
+		DEVICE_EVENT_POOLED(DeviceMotionEvent)
+
+		void toRecord(EventRecord &rec) const override {
+			DeviceEvent::toRecord(rec);
+			rec.motion = { x, y, relX, relY, buttons };
+		}
 
 		float relX;
 		float relY;
@@ -254,6 +535,7 @@ struct DeviceMotionEvent : public DevicePositionEvent
 
 }
 
+Q_DECLARE_METATYPE(Devices::EventRecord)
 Q_DECLARE_METATYPE(Devices::DeviceEvent)
 Q_DECLARE_METATYPE(Devices::DevicePositionEvent)
 Q_DECLARE_METATYPE(Devices::DeviceAxisEvent)
@@ -18,6 +18,11 @@ of their respective licenses. The copyright notice above does not apply
 to any 3rd-party components used within.
 */
 
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <vector>
 #include <QElapsedTimer>
 #include <QMetaEnum>
 #include <QTcpSocket>
@@ -33,19 +38,313 @@ Q_LOGGING_CATEGORY(lcTPC, "TPClientQt", QtWarningMsg);
 #endif
 
 
+//! Minimal streaming writer for compact JSON which appends directly to a byte buffer (typically a reused one, so no allocations are needed
+//! once it has grown to the size of the typical output). Strings are escaped exactly like Qt's JSON writer does, so the output is
+//! identical to `QJsonDocument::toJson(QJsonDocument::Compact)` as long as object members are written in sorted key order.
+class TPJsonWriter
+{
+	public:
+		//! Starts writing at the end of `buffer`.
+		explicit TPJsonWriter(QByteArray &buffer) : m_buf(buffer), m_start(buffer.size()) { }
+
+		//! Removes everything written so far from the buffer.
+		void discard() { m_buf.truncate(m_start); }
+
+		TPJsonWriter &beginObject() { separate(); m_buf.append('{'); m_first = true; return *this; }
+		TPJsonWriter &endObject() { m_buf.append('}'); m_first = false; return *this; }
+		TPJsonWriter &beginArray() { separate(); m_buf.append('['); m_first = true; return *this; }
+		TPJsonWriter &endArray() { m_buf.append(']'); m_first = false; return *this; }
+
+		//! Writes an object member name; `key` must be a plain ASCII string which needs no escaping (all TP API property names are).
+		TPJsonWriter &key(const char *key)
+		{
+			separate();
+			m_buf.append('"').append(key).append("\":", 2);
+			m_first = true;  // no separator before the value
+			return *this;
+		}
+		//! Writes an object member name which may need escaping.
+		TPJsonWriter &key(const QString &key)
+		{
+			value(key);
+			m_buf.append(':');
+			m_first = true;
+			return *this;
+		}
+
+		//! Writes a UTF-8 string value; a null `str` is written as an empty string, like `QJsonValue(const char *)` does.
+		TPJsonWriter &value(const char *str) { return value(str, str ? qsizetype(strlen(str)) : 0); }
+		TPJsonWriter &value(const char *str, qsizetype len)
+		{
+			separate();
+			m_buf.append('"');
+			appendEscaped(str, len);
+			m_buf.append('"');
+			return *this;
+		}
+		TPJsonWriter &value(const QString &str)
+		{
+			const QByteArray utf8 = str.toUtf8();
+			return value(utf8.constData(), utf8.size());
+		}
+		TPJsonWriter &value(bool b)
+		{
+			separate();
+			if (b)
+				m_buf.append("true", 4);
+			else
+				m_buf.append("false", 5);
+			return *this;
+		}
+		TPJsonWriter &null() { separate(); m_buf.append("null", 4); return *this; }
+
+		//! Writes a string, boolean or null JSON value and returns true, or returns false (writing nothing) for any other type.
+		bool simpleValue(const QJsonValue &v)
+		{
+			switch (v.type()) {
+				case QJsonValue::String: value(v.toString()); return true;
+				case QJsonValue::Bool:   value(v.toBool());   return true;
+				case QJsonValue::Null:   null();              return true;
+				default:                                      return false;
+			}
+		}
+
+	private:
+		void separate()
+		{
+			if (!m_first)
+				m_buf.append(',');
+			m_first = false;
+		}
+
+		void appendEscaped(const char *str, qsizetype len)
+		{
+			static constexpr char hex[] = "0123456789abcdef";
+			// Qt converts the UTF-8 to UTF-16 and back, which replaces any invalid sequences; only do that when needed.
+			if (!isValidUtf8(str, len)) {
+				const QByteArray fixed = QString::fromUtf8(str, len).toUtf8();
+				appendEscaped(fixed.constData(), fixed.size());
+				return;
+			}
+			const char *run = str;  // start of the bytes not yet copied
+			const char *const end = str + len;
+			for (const char *p = str; p != end; ++p) {
+				const uchar u = uchar(*p);
+				if (u >= 0x20 && u != '"' && u != '\\')
+					continue;
+				m_buf.append(run, p - run).append('\\');
+				switch (u) {
+					case '"':  m_buf.append('"');  break;
+					case '\\': m_buf.append('\\'); break;
+					case '\b': m_buf.append('b');  break;
+					case '\f': m_buf.append('f');  break;
+					case '\n': m_buf.append('n');  break;
+					case '\r': m_buf.append('r');  break;
+					case '\t': m_buf.append('t');  break;
+					default:
+						m_buf.append("u00", 3).append(hex[u >> 4]).append(hex[u & 0xF]);
+						break;
+				}
+				run = p + 1;
+			}
+			m_buf.append(run, end - run);
+		}
+
+		static bool isValidUtf8(const char *str, qsizetype len)
+		{
+#if (QT_VERSION >= QT_VERSION_CHECK(6, 3, 0))
+			return QByteArrayView(str, len).isValidUtf8();
+#else
+			// no public validator; any non-ASCII text takes the (always correct) slow path
+			return std::all_of(str, str + len, [](char c) { return uchar(c) < 0x80; });
+#endif
+		}
+
+		QByteArray &m_buf;
+		const qsizetype m_start;
+		bool m_first = true;
+};
+
+
+//! FIFO byte ring buffer for outgoing data. The storage grows as needed (by doubling) and is reused, so in steady state
+//! queueing and draining data needs no allocations. Large storage left over from a burst is released once the buffer is drained.
+class TPRingBuffer
+{
+	public:
+		qint64 size() const { return m_size; }
+		bool isEmpty() const { return !m_size; }
+
+		void append(const char *data, qint64 len)
+		{
+			if (len <= 0)
+				return;
+			if (m_size + len > m_capacity)
+				grow(m_size + len);
+			const qint64 tail = (m_head + m_size) % m_capacity;
+			const qint64 first = std::min(len, m_capacity - tail);
+			std::memcpy(m_buf.get() + tail, data, first);
+			std::memcpy(m_buf.get(), data + first, len - first);
+			m_size += len;
+		}
+
+		//! Start of the contiguous block of data at the front of the buffer; it is `readSize()` bytes long.
+		const char *readPointer() const { return m_buf.get() + m_head; }
+		qint64 readSize() const { return std::min(m_size, m_capacity - m_head); }
+
+		//! Removes `len` bytes (at most `readSize()`) from the front of the buffer.
+		void consume(qint64 len)
+		{
+			m_size -= len;
+			m_head = m_size ? (m_head + len) % m_capacity : 0;
+			if (!m_size && m_capacity > MaxIdleCapacity)
+				release();
+		}
+
+		void clear()
+		{
+			m_head = m_size = 0;
+			if (m_capacity > MaxIdleCapacity)
+				release();
+		}
+
+	private:
+		static constexpr qint64 MinCapacity = 16 * 1024;
+		static constexpr qint64 MaxIdleCapacity = 1024 * 1024;
+
+		void grow(qint64 required)
+		{
+			qint64 capacity = std::max(m_capacity, MinCapacity);
+			while (capacity < required)
+				capacity *= 2;
+			std::unique_ptr<char[]> buf(new char[capacity]);
+			// linearize the existing contents at the start of the new storage
+			const qint64 first = readSize();
+			if (m_size) {
+				std::memcpy(buf.get(), m_buf.get() + m_head, first);
+				std::memcpy(buf.get() + first, m_buf.get(), m_size - first);
+			}
+			m_buf.swap(buf);
+			m_capacity = capacity;
+			m_head = 0;
+		}
+
+		void release()
+		{
+			m_buf.reset();
+			m_capacity = 0;
+		}
+
+		std::unique_ptr<char[]> m_buf;
+		qint64 m_capacity = 0;
+		qint64 m_head = 0;
+		qint64 m_size = 0;
+};
+
+
+//! Bounded cache of the last value sent for each state ID, used to skip redundant state updates. Only 64-bit hashes of IDs and values are kept,
+//! in a fixed size table where each ID can be stored in one of a few slots starting at the one its hash maps to. If all of those are used by other IDs,
+//! the first one is replaced; a forgotten ID only means its next update is sent even if the value didn't change.
+class TPStateValueCache
+{
+	public:
+		int size() const { return int(m_slots.size()); }
+
+		//! Sets the number of slots, rounded up to a power of 2, or disables the cache with `entries <= 0`. All entries are cleared.
+		void resize(int entries)
+		{
+			size_t size = 0;
+			if (entries > 0) {
+				size = Ways;
+				while (size < size_t(entries))
+					size <<= 1;
+			}
+			m_slots.assign(size, Slot());
+			m_slots.shrink_to_fit();
+			m_mask = size ? size - 1 : 0;
+		}
+
+		void clear() { std::fill(m_slots.begin(), m_slots.end(), Slot()); }
+
+		//! Returns `false` if `value` is the last value recorded for `id`, otherwise records it and returns `true`. Always `true` when disabled.
+		bool update(const char *id, qsizetype idLen, const char *value, qsizetype valueLen)
+		{
+			if (m_slots.empty())
+				return true;
+			const quint64 idHash = hash(id, idLen) | 1;  // 0 marks an empty slot
+			const quint64 valueHash = hash(value, valueLen);
+			Slot &slot = findSlot(idHash);
+			if (slot.idHash == idHash && slot.valueHash == valueHash)
+				return false;
+			slot = { idHash, valueHash };
+			return true;
+		}
+
+		//! Forgets the value recorded for `id`, if any.
+		void remove(const char *id, qsizetype idLen)
+		{
+			if (m_slots.empty())
+				return;
+			const quint64 idHash = hash(id, idLen) | 1;
+			Slot &slot = findSlot(idHash);
+			if (slot.idHash == idHash)
+				slot = Slot();
+		}
+
+	private:
+		static constexpr size_t Ways = 4;  // number of slots an ID may be stored in
+
+		struct Slot {
+			quint64 idHash = 0;
+			quint64 valueHash = 0;
+		};
+
+		//! Returns the slot holding `idHash`, or else the first free slot for it, or else the slot it would replace.
+		Slot &findSlot(quint64 idHash)
+		{
+			const size_t home = idHash & m_mask;
+			Slot *free = nullptr;
+			for (size_t i = 0; i < Ways; ++i) {
+				Slot &slot = m_slots[(home + i) & m_mask];
+				if (slot.idHash == idHash)
+					return slot;
+				if (!slot.idHash && !free)
+					free = &slot;
+			}
+			return free ? *free : m_slots[home];
+		}
+
+		//! 64-bit FNV-1a hash
+		static quint64 hash(const char *data, qsizetype len)
+		{
+			quint64 h = 0xcbf29ce484222325ULL;
+			for (qsizetype i = 0; i < len; ++i)
+				h = (h ^ uchar(data[i])) * 0x100000001b3ULL;
+			return h;
+		}
+
+		std::vector<Slot> m_slots;
+		size_t m_mask = 0;
+};
+
+
 struct TPClientQt::Private
 {
 	Private(TPClientQt *q, const char *pluginId) :
 	  q(q),
 	  socket(new QTcpSocket(q)),
 	  pluginId(pluginId)
-	{ }
+	{
+		// reserving also keeps Qt5 from releasing the capacity when the buffer is cleared
+		outBuffer.reserve(maxPendingBytes + 1024);
+		inBuffer.reserve(16 * 1024);
+	}
 
 	inline void onSockStateChanged(QAbstractSocket::SocketState s)
 	{
 		qCDebug(lcTPC) << "Socket state changed:" << s;
 		switch (s) {
 			case QAbstractSocket::ConnectedState:
+				stateValueCache.clear();
 				socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
 #if (QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)) || !defined(Q_OS_WIN)
 				// On POSIX this needs to be set after connection according to Qt5 docs.
@@ -64,6 +363,16 @@ struct TPClientQt::Private
 				break;
 
 			case QAbstractSocket::UnconnectedState:
+				outBuffer.truncate(0);
+				pendingMessages = 0;
+				outQueue.clear();
+				updatePendingBytes();
+				stateValueCache.clear();
+				if (writeStats.flushes) {
+					qCDebug(lcTPC).nospace() << "Wrote " << writeStats.messages << " messages (" << writeStats.bytes << " bytes) in " << writeStats.flushes
+					                         << " socket writes; average " << writeStats.messagesPerFlush() << " and max. " << writeStats.maxMessagesPerFlush
+					                         << " messages per write; skipped " << writeStats.skippedStateUpdates << " unchanged state updates.";
+				}
 				if (tpInfo.paired) {
 					tpInfo.paired = false;
 					qCInfo(lcTPC) << "Closed Touch Portal Connection.";
@@ -126,8 +435,10 @@ struct TPClientQt::Private
 
 				const QJsonObject settings = arrayToObj(msg.value(QLatin1String("settings")));
 				Q_EMIT q->connected(tpInfo, settings);
-				Q_EMIT q->message(MessageType::info, msg);
-				Q_EMIT q->message(MessageType::settings, settings);
+				if (isDelivered(MessageType::info))
+					Q_EMIT q->message(MessageType::info, msg);
+				if (isDelivered(MessageType::settings))
+					Q_EMIT q->message(MessageType::settings, settings);
 				return;
 			}
 
@@ -141,6 +452,221 @@ struct TPClientQt::Private
 		Q_EMIT q->message(type, msg);
 	}
 
+	// Handles one line of data from TP (without the newline). The message type is read from the raw data first, and messages
+	// of types which aren't accepted are dropped right away without parsing the JSON.
+	void onTpLine(const char *line, qsizetype len)
+	{
+		if (len && line[len - 1] == '\r')
+			--len;
+		if (!len)
+			return;
+
+		const QLatin1String typeName = rawMessageType(line, line + len);
+		MessageType type = MessageType::Unknown;
+		if (typeName.size()) {
+			type = messageType(typeName);
+			if (!isAccepted(type))
+				return;
+		}
+
+		QJsonParseError jpe;
+		const QJsonDocument js = QJsonDocument::fromJson(QByteArray::fromRawData(line, int(len)), &jpe);
+		if (!js.isObject()) {
+			if (jpe.error == QJsonParseError::NoError)
+				qCWarning(lcTPC) << "Got empty or invalid JSON data, with no parsing error.";
+			else
+				qCWarning(lcTPC) << "Got invalid JSON data:" << jpe.errorString() << "; @" << jpe.offset;
+			qCDebug(lcTPC) << QByteArray(line, int(len));
+			return;
+		}
+		const QJsonObject msg = js.object();
+		//	qCDebug(lcTPC) << msg;
+		if (!typeName.size()) {
+			// not found by the raw scan, eg. because of escapes in the name; check the parsed message
+			const QJsonValue jMsgType = msg.value(QLatin1String("type"));
+			if (!jMsgType.isString()) {
+				qCWarning(lcTPC) << "TP message data missing the 'type' property.";
+				qCDebug(lcTPC) << msg;
+				return;
+			}
+			const QByteArray name = jMsgType.toString().toUtf8();
+			type = messageType(QLatin1String(name.constData(), name.size()));
+			if (!isAccepted(type))
+				return;
+		}
+		onTpMessage(type, msg);
+	}
+
+	// Returns true if a message of this type should be parsed; 'info' always is since it's needed for pairing.
+	bool isAccepted(MessageType type) const { return type == MessageType::info || isDelivered(type); }
+	// Returns true if messages of this type are emitted with the message() signal.
+	bool isDelivered(MessageType type) const { return acceptedTypes & (1u << int(type)); }
+
+	// Returns the enumerator for a message type name, or MessageType::Unknown (with a warning) if it isn't recognized.
+	static MessageType messageType(QLatin1String name)
+	{
+		static const QMetaEnum me = QMetaEnum::fromType<TPClientQt::MessageType>();
+		for (int i = 0, e = me.keyCount(); i < e; ++i) {
+			if (name == QLatin1String(me.key(i)))
+				return MessageType(me.value(i));
+		}
+		qCWarning(lcTPC) << "Unknown TP message 'type' property:" << name;
+		return MessageType::Unknown;
+	}
+
+	// Finds the value of the top-level "type" string property in a raw JSON object, without parsing the rest of it.
+	// TP sends it as the first property, so typically only the first few bytes are looked at. Returns a null string if not found.
+	static QLatin1String rawMessageType(const char *p, const char *const end)
+	{
+		int depth = 0;
+		bool expectKey = false;
+		while (p < end) {
+			switch (*p++) {
+				case '{':
+					expectKey = ++depth == 1;
+					break;
+				case '[':
+					++depth;
+					expectKey = false;
+					break;
+				case '}':
+				case ']':
+					--depth;
+					expectKey = false;
+					break;
+				case ',':
+					expectKey = depth == 1;
+					break;
+				case '"': {
+					const char *str = p;
+					while (p < end && *p != '"')
+						p += *p == '\\' ? 2 : 1;
+					if (p >= end)
+						return QLatin1String();
+					const qsizetype strLen = p++ - str;
+					if (!expectKey || strLen != 4 || std::memcmp(str, "type", 4)) {
+						expectKey = false;
+						break;
+					}
+					while (p < end && (*p == ':' || *p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'))
+						++p;
+					if (p >= end || *p != '"')
+						return QLatin1String();
+					const char *value = ++p;
+					// type names never need escaping; leave anything unusual to the full parser
+					while (p < end && *p != '"' && *p != '\\')
+						++p;
+					if (p >= end || *p != '"')
+						return QLatin1String();
+					return QLatin1String(value, int(p - value));
+				}
+				default:
+					break;
+			}
+		}
+		return QLatin1String();
+	}
+
+	bool canWrite() const { return socket->isWritable(); }
+
+	// Terminates the message which was just appended to the output buffer. Pending messages are written to the socket right away if
+	// one of the limits has been reached, otherwise the write is scheduled for when control returns to the event loop.
+	void commitMessage()
+	{
+		outBuffer.append('\n');
+		if (!pendingMessages++)
+			pendingSince.start();
+		if (outBuffer.size() >= maxPendingBytes || (maxPendingDelay > 0 && pendingSince.hasExpired(maxPendingDelay))) {
+			flushOutput();
+			return;
+		}
+		updatePendingBytes();
+		if (!flushScheduled) {
+			flushScheduled = true;
+			QMetaObject::invokeMethod(q, [this]() {
+				flushScheduled = false;
+				flushOutput();
+			}, Qt::QueuedConnection);
+		}
+	}
+
+	// Moves the pending messages to the socket, or to the end of the outgoing queue for whatever part doesn't fit into the socket's buffer.
+	void flushOutput()
+	{
+		if (outBuffer.isEmpty())
+			return;
+		if (!socket->isWritable()) {
+			outBuffer.truncate(0);
+			pendingMessages = 0;
+			updatePendingBytes();
+			return;
+		}
+		const qint64 len = outBuffer.size();
+		++writeStats.flushes;
+		writeStats.messages += pendingMessages;
+		writeStats.bytes += len;
+		writeStats.maxMessagesPerFlush = std::max(writeStats.maxMessagesPerFlush, quint32(pendingMessages));
+
+		qint64 written = 0;
+		if (outQueue.isEmpty() && (written = writeToSocket(outBuffer.constData(), len)) < 0)
+			return;
+		if (written < len)
+			outQueue.append(outBuffer.constData() + written, len - written);
+		outBuffer.truncate(0);
+		pendingMessages = 0;
+		updatePendingBytes();
+	}
+
+	// Moves as much of the outgoing queue to the socket as it will take; called whenever the socket has written some data.
+	// With `all` the socket's buffer size limit is ignored and everything is moved, eg. before closing the connection.
+	void drainOutput(bool all = false)
+	{
+		while (!outQueue.isEmpty()) {
+			const qint64 written = writeToSocket(outQueue.readPointer(), outQueue.readSize(), all);
+			if (written < 0)
+				return;
+			if (!written)
+				break;
+			outQueue.consume(written);
+		}
+		updatePendingBytes();
+	}
+
+	// Hands up to `len` bytes to the socket, limited by how much data it may hold at once (unless `all` is set). Returns the number of bytes
+	// accepted, or -1 after a write error, in which case all pending output is discarded and the connection is closed.
+	qint64 writeToSocket(const char *data, qint64 len, bool all = false)
+	{
+		const qint64 room = all ? len : maxSocketBytes - socket->bytesToWrite();
+		if (room <= 0)
+			return 0;
+		const qint64 written = socket->write(data, std::min(len, room));
+		if (written < 0) {
+			qCCritical(lcTPC()) << "Socket write error: " << socket->errorString();
+			outBuffer.truncate(0);
+			pendingMessages = 0;
+			outQueue.clear();
+			q->disconnect();
+		}
+		return written;
+	}
+
+	// Updates the thread-safe copy of the pending output size and emits the watermark signals when it crosses one of them.
+	void updatePendingBytes()
+	{
+		const qint64 pending = socket->bytesToWrite() + outQueue.size() + outBuffer.size();
+		pendingBytes.store(pending, std::memory_order_relaxed);
+		if (!aboveHighWatermark) {
+			if (highWatermark > 0 && pending > highWatermark) {
+				aboveHighWatermark = true;
+				Q_EMIT q->highWatermark(pending);
+			}
+		}
+		else if (highWatermark <= 0 || pending <= lowWatermark) {
+			aboveHighWatermark = false;
+			Q_EMIT q->lowWatermark(pending);
+		}
+	}
+
 	QJsonObject arrayToObj(const QJsonValue &arry) const
 	{
 		QJsonObject ret;
@@ -164,7 +690,27 @@ struct TPClientQt::Private
 	uint16_t tpPort = 12136;
 	int connTimeout = 10000;  // ms
 	TPClientQt::TPInfo tpInfo;
+	std::atomic<qint64> pendingBytes { 0 };  //!< total of socket->bytesToWrite(), outQueue and outBuffer sizes which can be read from other threads
+	QByteArray outBuffer;          //!< outgoing messages gathered for the next flush, each terminated with a newline
+	TPRingBuffer outQueue;         //!< flushed output which didn't fit into the socket's buffer yet
+	qint64 maxSocketBytes = 64 * 1024;  //!< most data the socket's own write buffer is allowed to hold
+	qint64 highWatermark = 0;      //!< pending output size above which highWatermark() is emitted; 0 to disable
+	qint64 lowWatermark = 0;       //!< pending output size at or below which lowWatermark() is emitted after highWatermark()
+	bool aboveHighWatermark = false;
+	TPStateValueCache stateValueCache;
+	QByteArray inBuffer;           //!< data read from the socket, starting with the beginning of an incomplete line
+	bool skipInputLine = false;    //!< set while dropping the rest of an incoming line which was too long
+	quint32 acceptedTypes = ~0u;   //!< bit flags of the MessageType values delivered with the message() signal
+	QElapsedTimer pendingSince;    //!< started when the first message is added to an empty outBuffer
+	int pendingMessages = 0;       //!< number of messages in outBuffer
+	int maxPendingBytes = 16384;   //!< outBuffer size at which it is written right away
+	int maxPendingDelay = 5;       //!< ms; age of the oldest pending message at which outBuffer is written right away
+	bool flushScheduled = false;
+	TPClientQt::WriteStats writeStats;
 	friend class TPClientQt;
+
+	//! Longest incoming line (message) which is buffered while waiting for its newline; TP messages are far shorter than this.
+	static constexpr qsizetype MaxInputLineLength = 4 * 1024 * 1024;
 };
 
 #define d_const  const_cast<const Private *>(d)
@@ -184,6 +730,7 @@ TPClientQt::TPClientQt(const char *pluginId, QObject *parent) :
 
 	QObject::connect(d->socket, &QTcpSocket::readyRead, this, &TPClientQt::onReadyRead);
 	QObject::connect(d->socket, &QTcpSocket::disconnected, this, &TPClientQt::disconnected);
+	QObject::connect(d->socket, &QTcpSocket::bytesWritten, this, [this]() { d->drainOutput(); });
 	QObject::connect(d->socket, &QTcpSocket::stateChanged, this, [this](QAbstractSocket::SocketState s) { d->onSockStateChanged(s); });
 #if (QT_VERSION < QT_VERSION_CHECK(5, 15, 0))
 	QObject::connect(d->socket, qOverload<QAbstractSocket::SocketError>(&QAbstractSocket::error), this, [this](QAbstractSocket::SocketError e) { d->onSocketError(e); });
@@ -202,6 +749,8 @@ bool TPClientQt::isConnected() const { return d_const->socket->state() == QAbstr
 QAbstractSocket::SocketState TPClientQt::socketState() const { return d_const->socket->state(); }
 QAbstractSocket::SocketError TPClientQt::socketError() const { return d_const->socket->error(); }
 QString TPClientQt::errorString() const { return d_const->lastError; }
+qint64 TPClientQt::bytesToWrite() const { return pendingBytes(); }
+qint64 TPClientQt::pendingBytes() const { return d_const->pendingBytes.load(std::memory_order_relaxed); }
 
 const TPClientQt::TPInfo &TPClientQt::tpInfo() const { return d_const->tpInfo; }
 
@@ -233,6 +782,57 @@ void TPClientQt::setHostProperties(const QString &nameOrAddress, uint16_t port)
 int TPClientQt::connectionTimeout() const { return d_const->connTimeout; }
 void TPClientQt::setConnectionTimeout(int timeoutMs) { d->connTimeout = timeoutMs; }
 
+int TPClientQt::writeCoalescingSize() const { return d_const->maxPendingBytes; }
+int TPClientQt::writeCoalescingDelay() const { return d_const->maxPendingDelay; }
+void TPClientQt::setWriteCoalescing(int maxBytes, int maxDelayMs)
+{
+	d->flushOutput();
+	d->maxPendingBytes = maxBytes;
+	d->maxPendingDelay = maxDelayMs;
+	if (maxBytes > 0)
+		d->outBuffer.reserve(maxBytes + 1024);
+}
+
+qint64 TPClientQt::writeHighWatermark() const { return d_const->highWatermark; }
+qint64 TPClientQt::writeLowWatermark() const { return d_const->lowWatermark; }
+void TPClientQt::setWriteWatermarks(qint64 high, qint64 low)
+{
+	d->highWatermark = std::max<qint64>(high, 0);
+	d->lowWatermark = std::max<qint64>(std::min(low, high), 0);
+	d->updatePendingBytes();
+}
+
+QVector<TPClientQt::MessageType> TPClientQt::messageTypeFilter() const
+{
+	QVector<MessageType> ret;
+	if (d_const->acceptedTypes != ~0u) {
+		const QMetaEnum me = QMetaEnum::fromType<TPClientQt::MessageType>();
+		for (int i = 0, e = me.keyCount(); i < e; ++i) {
+			if (d_const->acceptedTypes & (1u << me.value(i)))
+				ret.append(MessageType(me.value(i)));
+		}
+	}
+	return ret;
+}
+
+void TPClientQt::setMessageTypeFilter(const QVector<MessageType> &types)
+{
+	if (types.isEmpty()) {
+		d->acceptedTypes = ~0u;
+		return;
+	}
+	d->acceptedTypes = 0;
+	for (const MessageType type : types)
+		d->acceptedTypes |= 1u << int(type);
+}
+
+int TPClientQt::stateValueCacheSize() const { return d_const->stateValueCache.size(); }
+void TPClientQt::setStateValueCacheSize(int entries) { d->stateValueCache.resize(entries); }
+void TPClientQt::clearStateValueCache() { d->stateValueCache.clear(); }
+
+TPClientQt::WriteStats TPClientQt::writeStats() const { return d_const->writeStats; }
+void TPClientQt::resetWriteStats() { d->writeStats = WriteStats(); }
+
 void TPClientQt::connect()
 {
 	if (d_const->socket->state() != QAbstractSocket::UnconnectedState) {
@@ -253,69 +853,170 @@ void TPClientQt::connect()
 #endif
 
 	d->tpInfo = TPInfo();
+	d->inBuffer.truncate(0);
+	d->skipInputLine = false;
 	d->socket->connectToHost(d->tpHost, d->tpPort);
 }
 
 void TPClientQt::disconnect() const
 {
+	flush();
+	d->drainOutput(true);
 	d_const->socket->flush();
 	d_const->socket->disconnectFromHost();
 }
 
 void TPClientQt::write(const QByteArray &data) const
 {
-	if (!d_const->socket || !d_const->socket->isWritable())
+	if (!d_const->canWrite())
 		return;
-	const int len = data.length();
-	qint64 bw = 0, sbw = 0;
-	do {
-		sbw = d_const->socket->write(data);
-		bw += sbw;
-	}
-	while (bw != len && sbw > -1);
-	if (sbw < 0) {
-		qCCritical(lcTPC()) << "Socket write error: " << d->socket->errorString();
-		disconnect();
+	d->outBuffer.append(data);
+	d->commitMessage();
+}
+
+void TPClientQt::flush() const
+{
+	d->flushOutput();
+}
+
+// High level API with JSON serialization fast paths
+
+void TPClientQt::stateUpdate(const char *id, const char *value, bool force) const
+{
+	if (!d_const->canWrite())
+		return;
+	const qsizetype idLen = id ? qsizetype(strlen(id)) : 0;
+	const qsizetype valueLen = value ? qsizetype(strlen(value)) : 0;
+	if (!d->stateValueCache.update(id, idLen, value, valueLen) && !force) {
+		++d->writeStats.skippedStateUpdates;
 		return;
 	}
-	d_const->socket->write("\n", 1);
+	TPJsonWriter(d->outBuffer).beginObject()
+		.key("id").value(id, idLen)
+		.key("type").value("stateUpdate")
+		.key("value").value(value, valueLen)
+		.endObject();
+	d->commitMessage();
 }
 
-// private
+void TPClientQt::createState(const char *id, const char *parentGroup, const char *desc, const char *defaultValue, bool force) const
+{
+	if (!d_const->canWrite())
+		return;
+	d->stateValueCache.remove(id, id ? qsizetype(strlen(id)) : 0);
+	TPJsonWriter(d->outBuffer).beginObject()
+		.key("defaultValue").value(defaultValue)
+		.key("desc").value(desc)
+		.key("forceUpdate").value(force)
+		.key("id").value(id)
+		.key("parentGroup").value(parentGroup)
+		.key("type").value("createState")
+		.endObject();
+	d->commitMessage();
+}
 
-void TPClientQt::onReadyRead()
+void TPClientQt::removeState(const char *id) const
 {
-	QJsonParseError jpe;
-	while (d->socket->canReadLine()) {
-		const QByteArray &bytes = d->socket->readLine();
-		if (bytes.isEmpty())
-			continue;;
-		const QJsonDocument &js = QJsonDocument::fromJson(bytes, &jpe);
-		if (!js.isObject()) {
-			if (jpe.error == QJsonParseError::NoError)
-				qCWarning(lcTPC) << "Got empty or invalid JSON data, with no parsing error.";
-			else
-				qCWarning(lcTPC) << "Got invalid JSON data:" << jpe.errorString() << "; @" << jpe.offset;
-			qCDebug(lcTPC) << bytes;
-			continue;
+	if (!d_const->canWrite())
+		return;
+	d->stateValueCache.remove(id, id ? qsizetype(strlen(id)) : 0);
+	TPJsonWriter(d->outBuffer).beginObject()
+		.key("id").value(id)
+		.key("type").value("removeState")
+		.endObject();
+	d->commitMessage();
+}
+
+void TPClientQt::choiceUpdate(const char *id, const QJsonArray &values) const
+{
+	choiceUpdate(id, nullptr, values);
+}
+
+void TPClientQt::choiceUpdate(const char *id, const char *instanceId, const QJsonArray &values) const
+{
+	if (!d_const->canWrite())
+		return;
+	TPJsonWriter w(d->outBuffer);
+	w.beginObject().key("id").value(id);
+	if (instanceId)
+		w.key("instanceId").value(instanceId);
+	w.key("type").value("choiceUpdate");
+	w.key("value").beginArray();
+	for (const QJsonValue &v : values) {
+		if (!w.simpleValue(v)) {
+			// numbers or nested structures; let Qt serialize it
+			w.discard();
+			QJsonObject msg { {"type", "choiceUpdate"}, {"id", id}, {"value", values} };
+			if (instanceId)
+				msg.insert(QLatin1String("instanceId"), instanceId);
+			send(msg);
+			return;
 		}
-		const QJsonObject &msg = js.object();
-		//	qCDebug(lcTPC) << msg;
-		const QJsonValue &jMsgType = msg.value(QLatin1String("type"));
-		if (!jMsgType.isString()) {
-			qCWarning(lcTPC) << "TP message data missing the 'type' property.";
-			qCDebug(lcTPC) << msg;
-			continue;
+	}
+	w.endArray().endObject();
+	d->commitMessage();
+}
+
+void TPClientQt::triggerEvent(const char *eventId, const QJsonObject &states) const
+{
+	if (!d_const->canWrite())
+		return;
+	TPJsonWriter w(d->outBuffer);
+	w.beginObject().key("eventId").value(eventId);
+	w.key("states").beginObject();
+	// QJsonObject iterates in sorted key order
+	for (auto it = states.constBegin(), en = states.constEnd(); it != en; ++it) {
+		if (!w.key(it.key()).simpleValue(it.value())) {
+			w.discard();
+			send({ {"type", "triggerEvent"}, {"eventId", eventId}, {"states", states} });
+			return;
 		}
+	}
+	w.endObject();
+	w.key("type").value("triggerEvent");
+	w.endObject();
+	d->commitMessage();
+}
+
+// private
 
-		bool ok;
-		MessageType iMsgType = (MessageType)QMetaEnum::fromType<TPClientQt::MessageType>().keyToValue(qPrintable(jMsgType.toString()), &ok);
-		if (!ok) {
-			iMsgType = MessageType::Unknown;
-			qCWarning(lcTPC) << "Unknown TP message 'type' property:" << jMsgType.toString();
+void TPClientQt::onReadyRead()
+{
+	QByteArray &buf = d->inBuffer;
+	const qint64 avail = d->socket->bytesAvailable();
+	if (avail <= 0)
+		return;
+	const qsizetype used = buf.size();
+	buf.resize(used + avail);
+	const qint64 len = d->socket->read(buf.data() + used, avail);
+	buf.resize(used + std::max<qint64>(len, 0));
+
+	const char *const data = buf.constData();
+	const char *const end = data + buf.size();
+	const char *line = data;
+	// any bytes before `used` were already scanned and contain no newline
+	const char *next = data + used;
+	while (const char *nl = static_cast<const char *>(std::memchr(next, '\n', end - next))) {
+		if (Q_UNLIKELY(d->skipInputLine))
+			d->skipInputLine = false;  // end of the line being dropped
+		else
+			d->onTpLine(line, nl - line);
+		line = next = nl + 1;
+	}
+	// drop an incomplete line which is too long (or still being skipped) instead of buffering it indefinitely
+	if (Q_UNLIKELY(d->skipInputLine || end - line > Private::MaxInputLineLength)) {
+		if (!d->skipInputLine) {
+			qCWarning(lcTPC) << "Dropping incoming data with no line ending after" << (end - line) << "bytes.";
+			d->skipInputLine = true;
 		}
-		d->onTpMessage(iMsgType, msg);
+		buf.truncate(0);
+		return;
 	}
+	// keep the beginning of an incomplete line for the next read
+	if (line == end)
+		buf.truncate(0);
+	else if (line != data)
+		buf.remove(0, line - data);
 }
 
 #include "moc_TPClientQt.cpp"
@@ -117,6 +117,17 @@ class TPCLIENT_LIB_EXPORT TPClientQt : public QObject
 			QString status;               //!< The 'status' property from initial 'info' message (typically "paired"); This does _not_ get changed after disconnection (see `paired`).
 		};
 
+		//! Statistics about writing outgoing messages to the network socket.  \sa writeStats(), setWriteCoalescing()
+		struct WriteStats {
+			quint64 messages = 0;             //!< Number of messages written.
+			quint64 flushes = 0;              //!< Number of socket writes, each containing one or more messages.
+			quint64 bytes = 0;                //!< Total number of bytes written.
+			quint32 maxMessagesPerFlush = 0;  //!< Largest number of messages written at once.
+			quint64 skippedStateUpdates = 0;  //!< Number of state updates which weren't sent because the value was unchanged.  \sa setStateValueCacheSize()
+			//! Returns the average number of messages per socket write.
+			double messagesPerFlush() const { return flushes ? double(messages) / flushes : 0.0; }
+		};
+
 		//! Structure for action/connector data id = value pairs sent from TP. Each action/connector sends an array of these.
 		//! Used with some convenience functions in this class.  \sa actionDataItem(), actionDataToItemArray()
 		struct ActionDataItem {
@@ -147,6 +158,12 @@ class TPCLIENT_LIB_EXPORT TPClientQt : public QObject
 		QAbstractSocket::SocketError socketError() const;
 		//! Returns the current TCP/IP network error, if any, as a human-readable string. \sa QIODevice::errorString()
 		QString errorString() const;
+		//! Returns the number of bytes which have been sent but not yet written to the network, for example because Touch Portal isn't reading them fast enough
+		//! or because they're still waiting to be gathered with other messages (see `setWriteCoalescing()`).
+		//! Unlike most other methods, this one may safely be called from any thread.  \sa setWriteWatermarks()
+		qint64 pendingBytes() const;
+		//! Same as `pendingBytes()`.
+		qint64 bytesToWrite() const;
 		//! Returns information about the currently connected Touch Portal instance. This data is saved from the initial connection's 'info' message. \sa TPInfo struct.
 		//! \note This reference becomes invalid when `connect()` is called.
 		const TPClientQt::TPInfo &tpInfo() const;
@@ -172,6 +189,46 @@ class TPCLIENT_LIB_EXPORT TPClientQt : public QObject
 		//! The default value is 10000 (10s). Call this method with no argument to reset the timeout value to default.  \sa connectionTimeout()
 		void setConnectionTimeout(int timeoutMs = 10000);
 
+		//! Returns the message types set with `setMessageTypeFilter()`, or an empty list if all types are delivered.
+		QVector<MessageType> messageTypeFilter() const;
+		//! Sets which types of messages from Touch Portal are delivered with the `message()` signal. Messages of any other type are dropped after reading
+		//! only their type from the raw data, without parsing the JSON. `MessageType::info` is always processed since it is needed for pairing,
+		//! and `connected()` is always emitted, but the 'info' message and the settings it carries are only delivered with `message()` if their types are in the filter.
+		//! An empty list delivers all types (the default).  \sa messageTypeFilter()
+		void setMessageTypeFilter(const QVector<MessageType> &types);
+
+		//! Returns the number of pending outgoing bytes at which they are written to the socket right away.  \sa setWriteCoalescing()
+		int writeCoalescingSize() const;
+		//! Returns the maximum time, in milliseconds, an outgoing message is held before being written to the socket.  \sa setWriteCoalescing()
+		int writeCoalescingDelay() const;
+		//! Outgoing messages are gathered and written to the network socket together once control returns to the event loop, or earlier when
+		//! `maxBytes` of messages are pending or the oldest pending message is `maxDelayMs` old, whichever comes first. A `maxBytes` of `<= 0` disables gathering
+		//! (every message is written right away) and a `maxDelayMs` of `<= 0` removes the time limit. Defaults are 16384 bytes and 5ms.
+		//! Any pending messages are written before the new limits are applied.  \sa flush(), writeStats()
+		void setWriteCoalescing(int maxBytes = 16384, int maxDelayMs = 5);
+		//! Returns the pending output size above which the `highWatermark()` signal is emitted, or 0 if disabled.  \sa setWriteWatermarks()
+		qint64 writeHighWatermark() const;
+		//! Returns the pending output size at or below which the `lowWatermark()` signal is emitted after `highWatermark()`.  \sa setWriteWatermarks()
+		qint64 writeLowWatermark() const;
+		//! Sets the `pendingBytes()` limits for the `highWatermark()` and `lowWatermark()` signals, which can be used to slow down or hold back outgoing messages
+		//! while Touch Portal isn't keeping up. The `low` limit is capped at `high`. A `high` limit of `<= 0` disables the signals (the default);
+		//! if the high watermark had been exceeded, `lowWatermark()` is emitted right away.
+		void setWriteWatermarks(qint64 high, qint64 low);
+		//! Returns the number of entries in the state value cache, or 0 if it is disabled.  \sa setStateValueCacheSize()
+		int stateValueCacheSize() const;
+		//! Enables a cache of the last value sent for each state ID, with room for `entries` states (rounded up to a power of 2), or disables it with `entries <= 0` (the default).
+		//! While enabled, `stateUpdate()` skips sending a value which is the same as the last one sent for that state, unless forced.
+		//! Only 64-bit hashes of the IDs and values are kept, using 16 bytes per entry regardless of the actual lengths. If more states are used than fit,
+		//! some of them are forgotten and their next update is sent even if unchanged. Creating or removing a state also forgets its value.
+		//! The cache is cleared whenever this method is called and upon each new connection.  \sa clearStateValueCache()
+		void setStateValueCacheSize(int entries);
+		//! Forgets all values in the state value cache, so the next update of every state is sent.
+		void clearStateValueCache();
+		//! Returns statistics about writing outgoing messages to the network socket since the client was created or `resetWriteStats()` was called.
+		WriteStats writeStats() const;
+		//! Resets all the `writeStats()` counters to zero.
+		void resetWriteStats();
+
 		//! \}
 
 	Q_SIGNALS:
@@ -191,18 +248,25 @@ class TPCLIENT_LIB_EXPORT TPClientQt : public QObject
 		void error(QAbstractSocket::SocketError error);
 		//! Emitted when any message is received from Touch Portal. Refer to the TP API for specifics of each message type and what data to expect
 		//! in the JSON `message` object.  The `type` is simply derived from the 'type' value found in each TP message, or `TPClientQt::MessageType::Unknown`
-		//! if the message type wasn't recognized (eg. TP is using a newer API than this client supports).
+		//! if the message type wasn't recognized (eg. TP is using a newer API than this client supports). Only the types set with `setMessageTypeFilter()` are delivered, if any.
 		void message(TPClientQt::MessageType type, const QJsonObject &message);
+		//! Emitted when the amount of outgoing data waiting to be written to the network (`pendingBytes`) rises above the high limit set with `setWriteWatermarks()`.
+		//! It is not emitted again until after `lowWatermark()` has been emitted.
+		void highWatermark(qint64 pendingBytes);
+		//! Emitted after `highWatermark()` once the amount of outgoing data waiting to be written to the network (`pendingBytes`) drops to the low limit
+		//! set with `setWriteWatermarks()`, or the limits are disabled, or the connection is closed.
+		void lowWatermark(qint64 pendingBytes);
 
 	public:
 		//! \name  Convenience methods / High level API; primary overloads, not for signal/slots connections.
 		//! \{
 
-		//! Send a state update with given `id` and `value` strings.
-		inline void stateUpdate(const char *id, const char *value) const;
+		//! Send a state update with given `id` and `value` strings. If the state value cache is enabled, the update is skipped when `value` is the same
+		//! as the last one sent for this state, unless `force` is `true`.  \sa setStateValueCacheSize()
+		void stateUpdate(const char *id, const char *value, bool force = false) const;
 
 		//! Create a new dynamic state with given `id`, `parentGroup`, `description` and default value strings. Passing `nullptr` to `defaultValue` is same as using an empty string.
-		inline void createState(const char *id, const char *parentGroup, const char *desc, const char *defaultValue, bool force = false) const;
+		void createState(const char *id, const char *parentGroup, const char *desc, const char *defaultValue, bool force = false) const;
 		//! Create a new dynamic state with given `id`, `parentGroup`, `description` and default value strings.
 		inline void createState(const std::string &id, const std::string &parentGroup, const std::string &desc, const std::string &defaultValue = "", bool force = false) const { createState(id.c_str(), parentGroup.c_str(), desc.c_str(), defaultValue.c_str(), force); }
 		//! Create a new dynamic state with given `id`, `description` and default value strings. Passing `nullptr` to `defaultValue` is same as using an empty string.
@@ -211,7 +275,7 @@ class TPCLIENT_LIB_EXPORT TPClientQt : public QObject
 		inline void createState(const std::string &id, const std::string &desc, const std::string &defaultValue = "", bool force = false) const { createState(id.c_str(), nullptr, desc.c_str(), defaultValue.c_str(), force); }
 
 		//! Delete (remove) a dynamic state with given `id` string.
-		inline void removeState(const char *id) const;
+		void removeState(const char *id) const;
 		//! Delete (remove) a dynamic state with given `id` string.
 		inline void removeState(const std::string &id) const { removeState(id.c_str()); }
 
@@ -223,7 +287,7 @@ class TPCLIENT_LIB_EXPORT TPClientQt : public QObject
 		inline void stateListUpdate(const char *id, const QStringList &values) const { stateListUpdate(id, QJsonArray::fromStringList(values)); }
 
 		//! Update a list of action data choices for action data with given `id` using a `QJsonArray` of strings. `QJsonArray` is most efficient as it requires no further conversion before sending.
-		inline void choiceUpdate(const char *id, const QJsonArray &values) const;
+		void choiceUpdate(const char *id, const QJsonArray &values) const;
 		//! Update a list of action data choices for action data with given `id` using a vector of const char strings.
 		inline void choiceUpdate(const char *id, const QVector<const char *> &values) const { choiceUpdate(id, stringContainerToJsonArray(values)); }
 		//! Update a list of action data choices for action data with given `id` using a list of QStrings.
@@ -231,7 +295,7 @@ class TPCLIENT_LIB_EXPORT TPClientQt : public QObject
 		//! Update a list of action data choices for action data with given `id` using a `std::vector` of `std::string` types.
 		inline void choiceUpdate(const std::string &id, const std::vector<std::string> &values) const { choiceUpdate(id.c_str(), stringContainerToJsonArray(values)); }
 		//! Update a list of action data choices for action data with given `id` and specific `instanceId` reported by TP, using a `QJsonArray` of strings. `QJsonArray` is most efficient as it requires no further conversion before sending.
-		inline void choiceUpdate(const char *id, const char *instanceId, const QJsonArray &values) const;
+		void choiceUpdate(const char *id, const char *instanceId, const QJsonArray &values) const;
 		//! Update a list of action data choices for action data with given `id` and specific `instanceId` reported by TP, using a vector of const char strings.
 		inline void choiceUpdate(const char *id, const char *instanceId, const QVector<const char *> &values) const { choiceUpdate(id, instanceId, stringContainerToJsonArray(values)); }
 		//! Update a list of action data choices for action data with given `id` and specific `instanceId` reported by TP, using a vector of const char strings.
@@ -276,7 +340,7 @@ class TPCLIENT_LIB_EXPORT TPClientQt : public QObject
 
 		//! Trigger a plugin's TP event with given `id` with optional `states` object. The `states` array should contain
 		//! key/value pairs corresponding to how the event is defined in the plugins entry.tp. For example a `QJsonArray<QJsonObject>({ {"localState1", "value 1"}, {"localState2", "value 2"} })`.
-		inline void triggerEvent(const char *eventId, const QJsonObject &states = QJsonObject()) const;
+		void triggerEvent(const char *eventId, const QJsonObject &states = QJsonObject()) const;
 		//! Trigger a plugin's TP event with given `id` and `states`. The `states` variant list should be some kind of array containing
 		//! key/value pairs corresponding to how the event is defined in the plugins entry.tp. For example a `QVariantList<QVariantMap>({ {"localState1", "value 1"}, {"localState2", "value 2"} })`.
 		inline void triggerEvent(const char *eventId, const QVariantMap &states) const { triggerEvent(eventId,  QJsonObject::fromVariantMap(states)); }
@@ -328,13 +392,19 @@ class TPCLIENT_LIB_EXPORT TPClientQt : public QObject
 		//! \{
 
 		//! Low-level API: Send JSON message data to Touch Portal. `object` should contain one TP message.
-		//! All other methods for sending structured data are conveniences for this method.
+		//! Most other methods for sending structured data are conveniences for this method. The most frequently used ones (`stateUpdate()`, `createState()`,
+		//! `choiceUpdate()` and `triggerEvent()`) instead serialize their message directly into a reused buffer, which produces the same JSON without building a `QJsonObject`.
 		inline void send(const QJsonObject &object) const { write(encode(object)); }
 		//! Low-level API: Send a JSON representation of a variant map to Touch Portal. `map` should contain one TP message. The map is serialized as QJsonObject type.
 		inline void sendMap(const QVariantMap &map) const { write(encode(QJsonObject::fromVariantMap(map))); }
 		//! Low-level API: Write UTF-8 bytes directly to Touch Portal. `data` should contain one TP message in the form of a serialized (UTF8 text) JSON object.
-		//! A newline is automatically added after `data` is sent (as per TP API specs). All messages are ultimately sent via this method.
+		//! A newline is automatically added after `data` is sent (as per TP API specs).
+		//! The message is gathered with others and written to the network later, see `setWriteCoalescing()`. Data which the socket can't take right away
+		//! is queued and written as the socket catches up (monitor with `pendingBytes()` or the watermark signals).
 		void write(const QByteArray &data) const;
+		//! Low-level API: Writes any pending outgoing messages to the network socket right away, instead of waiting for control to return to the event loop.
+		//! This may be useful in latency-critical code paths which send a message and then do more lengthy work.  \sa setWriteCoalescing()
+		void flush() const;
 
 		//! \}
 
@@ -343,6 +413,8 @@ class TPCLIENT_LIB_EXPORT TPClientQt : public QObject
 
 		//! Send a state update with given `id` and `value` strings.
 		inline void stateUpdate(const QByteArray &id, const QByteArray &value) const { stateUpdate(id.constData(), value.constData()); }
+		//! Send a state update with given `id` and `value` strings, optionally bypassing the state value cache with `force`.  \sa setStateValueCacheSize()
+		inline void stateUpdate(const QByteArray &id, const QByteArray &value, bool force) const { stateUpdate(id.constData(), value.constData(), force); }
 		//! Send a state update with given `id` and `value` strings.
 		inline void stateUpdate(QStringView id, QStringView value) const { stateUpdate(qsvPrintable(id), qsvPrintable(value)); }
 		//! Send a state update with given `id` and `value` strings.
@@ -594,48 +666,6 @@ void TPClientQt::connect(int timeout, const QString &host, uint16_t port)
 	connect();
 }
 
-inline
-void TPClientQt::stateUpdate(const char *id, const char *value) const
-{
-	send({
-		{"type", "stateUpdate"},
-		{"id", id},
-		{"value", value}
-	});
-}
-
-inline
-void TPClientQt::createState(const char *id, const char *parentGroup, const char *desc, const char *defaultValue, bool force) const
-{
-	send({
-		{"type", "createState"},
-		{"id", id},
-		{"desc", desc ? desc : ""},
-		{"defaultValue", defaultValue ? defaultValue : ""},
-		{"parentGroup", parentGroup ? parentGroup : ""},
-		{"forceUpdate", force}
-	});
-}
-
-inline
-void TPClientQt::removeState(const char *id) const
-{
-	send({
-		{"type", "removeState"},
-		{"id", id},
-	});
-}
-
-inline
-void TPClientQt::choiceUpdate(const char *id, const QJsonArray &values) const
-{
-	send({
-		{"type", "choiceUpdate"},
-		{"id", id},
-		{"value", values}
-	});
-}
-
 inline
 void TPClientQt::stateListUpdate(const char *id, const QJsonArray &values) const
 {
@@ -646,17 +676,6 @@ void TPClientQt::stateListUpdate(const char *id, const QJsonArray &values) const
 	});
 }
 
-inline
-void TPClientQt::choiceUpdate(const char *id, const char *instanceId, const QJsonArray &values) const
-{
-	send({
-		{"type", "choiceUpdate"},
-		{"id", id},
-		{"instanceId", instanceId},
-		{"value", values}
-	});
-}
-
 inline
 void TPClientQt::connectorUpdate(const char *shortId, uint8_t value) const
 {
@@ -756,17 +775,6 @@ void TPClientQt::showNotification(QStringView notificationId, QStringView title,
 }
 
 
-inline
-void TPClientQt::triggerEvent(const char *eventId, const QJsonObject &states) const
-{
-	send({
-		{"type", "triggerEvent"},
-		{"eventId", eventId},
-		{"states", states}
-	});
-}
-
-
 // static
 inline
 TPClientQt::ActionDataItem TPClientQt::actionDataItem(int index, const QJsonArray &data, const ActionDataItem &defaultItem)
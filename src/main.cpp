@@ -33,6 +33,7 @@ to any 3rd-party components used within.
 #include <iostream>
 #include <csignal>
 
+#include "DeviceManager.h"
 #include "logging.h"
 // #include "ExceptionHandler.h"
 #include "Logger.h"
@@ -70,6 +71,8 @@ to any 3rd-party components used within.
 #define OPT_XITERLY   QStringLiteral("x")  // exit w/out starting
 #define OPT_TPHOSTP   QStringLiteral("t")  // TP host:port
 #define OPT_PLUGNID   QStringLiteral("i")  // plugin ID
+#define OPT_EVQUEUE   QStringLiteral("q")  // device event queue size
+#define OPT_NOTHRED   QStringLiteral("n")  // don't use input thread
 
 void sigHandler(int s)
 {
@@ -130,6 +133,8 @@ int main(int argc, char *argv[])
 		{ {OPT_XITERLY, QStringLiteral("exit")},    qApp->translate("main", "Exit w/out starting. For example after rotating logs.") },
 		{ {OPT_TPHOSTP, QStringLiteral("tphost")},  qApp->translate("main", "Touch Portal host address and optional port number in the format of 'host_name_or_address[:port_number]'. Default is '127.0.0.1:12136'."), QStringLiteral("host[:port]") },
 		{ {OPT_PLUGNID, QStringLiteral("pluginid")},qApp->translate("main", "Use a custom Touch Portal Plugin ID for this instance (only use with custom entry.tp)."), QStringLiteral("ID") },
+		{ {OPT_EVQUEUE, QStringLiteral("queuesize")}, qApp->translate("main", "Capacity of the device event queue (rounded up to a power of 2). Default is %1.").arg(DEVICE_EVENT_QUEUE_DEFAULT_CAPACITY), QStringLiteral("events") },
+		{ {OPT_NOTHRED, QStringLiteral("nothread")},  qApp->translate("main", "Read controller input in the main thread instead of a dedicated input thread.") },
 	});
 	clp.addHelpOption();
 	clp.addVersionOption();
@@ -190,6 +195,17 @@ int main(int argc, char *argv[])
 		}
 	}
 
+	if (clp.isSet(OPT_EVQUEUE)) {
+		const uint k = clp.value(OPT_EVQUEUE).toUInt(&ok);
+		if (ok && k)
+			DeviceManager::instance()->setEventQueueCapacity(k);
+		else
+			clp.showHelp(1);
+	}
+
+	if (clp.isSet(OPT_NOTHRED))
+		DeviceManager::instance()->setInputThreadEnabled(false);
+
 	QString logFilterRules;
 
 	quint8 effectiveLevel = fileLevel > -1 ? std::min(stdoutLevel, fileLevel) : stdoutLevel;
@@ -32,11 +32,13 @@ to any 3rd-party components used within.
 #define PLUGIN_STR_EV_STATE_PGCHANGE  PLUGIN_SYSTEM_NAME PLUGIN_STR_PATH_SEP "PageChange"
 #define PLUGIN_STR_CAT_DEVICES_NAME   "Device Information"
 #define PLUGIN_STR_CAT_ASSIGNED_NAME  "Device Assignments"
+#define PLUGIN_STR_CAT_LATENCY_NAME   "Input Latency"
 #define PLUGIN_STR_STATEID_DEVICES    "devices"
 #define PLUGIN_STR_STATEID_DISPLAY    "display"
 #define PLUGIN_STR_STATEID_ASSIGNED   "assigned"
 #define PLUGIN_STR_STATEID_DEFAULT    "default"
 #define PLUGIN_STR_STATEID_FIRST      "first"
+#define PLUGIN_STR_STATEID_LATENCY    "latency"
 
 #define PLUGIN_STR_MISC_ACT_DATA_PLACEHOLDER_PFX  "select "
 
@@ -175,6 +177,7 @@ enum ChoiceListIdToken : uint8_t
 	CLID_DeviceFilterMatchWhat,
 	CLID_DeviceFilterMatchType,
 	CLID_DefaultDeviceDevName,
+	CLID_AxisCondDevName,
 
 	CLID_ENUM_MAX
 };
@@ -188,6 +191,7 @@ static constexpr const char * g_choiceListTokenStrings[CLID_ENUM_MAX]
 	"filter.matchWhat",
 	"filter.matchType",
 	"default.device",
+	"axis.device",
 };
 static inline const char * const * choiceListTokenStrings() { return g_choiceListTokenStrings; }
 
@@ -237,6 +241,7 @@ enum ActionTokens : uint8_t
 	AID_DeviceControl,
 	AID_DeviceFilter,
 	AID_DeviceDefault,
+	AID_AxisConditioning,
 
 	CA_RescanDevices,
 	CA_FullStatusUpdate,
@@ -248,9 +253,18 @@ enum ActionTokens : uint8_t
 	CA_ToggleReport,
 	CA_RefreshReport,
 	CA_ClearFilter,
+	CA_SendAll,
+	CA_SendStatesOnly,
+	CA_SendEventsOnly,
 
 	ST_SendReportStates,
 	ST_SendReportEvents,
+	ST_CoalesceEvents,
+	ST_HighPriorityInput,
+	ST_LatencyStatsInterval,
+	ST_OutputBacklogLimit,
+	ST_ValuePrecision,
+	ST_MaxUpdateRate,
 	// ST_SettingsVersion,
 
 	// send only
@@ -285,6 +299,7 @@ static constexpr const char * g_actionTokenStrings[AT_ENUM_MAX] {
 	"device",
 	"filter",
 	"default",
+	"axis",
 
 	"Rescan System Devices",
 	"Update All States & Events",
@@ -296,9 +311,18 @@ static constexpr const char * g_actionTokenStrings[AT_ENUM_MAX] {
 	"Toggle Reporting",
 	"Refresh Report",
 	"Clear Report Filter",
+	"Send States & Events",
+	"Send States Only",
+	"Send Events Only",
 
 	"Send Device Reports as States",
 	"Send Device Reports as Events",
+	"Merge Rapid Axis Movements",
+	"High Priority Input Thread",
+	"Latency Statistics Interval (seconds, 0 = off)",
+	"Output Backlog Limit (KB, 0 = unlimited)",
+	"Axis & Position Decimal Places (-1 = full precision)",
+	"Axis & Motion Max. Updates per Second (0 = unlimited)",
 	// "Settings Version",
 
 	"Starting",
@@ -334,6 +358,7 @@ static int tokenFromName(const QByteArray &name, int deflt = AT_Unknown)
 	  { g_actionTokenStrings[AID_DeviceControl],   AID_DeviceControl },
 	  { g_actionTokenStrings[AID_DeviceFilter],    AID_DeviceFilter },
 	  { g_actionTokenStrings[AID_DeviceDefault],   AID_DeviceDefault },
+	  { g_actionTokenStrings[AID_AxisConditioning], AID_AxisConditioning },
 
 	  { g_actionTokenStrings[CA_RescanDevices],    CA_RescanDevices },
 	  { g_actionTokenStrings[CA_FullStatusUpdate], CA_FullStatusUpdate },
@@ -344,6 +369,9 @@ static int tokenFromName(const QByteArray &name, int deflt = AT_Unknown)
 	  { g_actionTokenStrings[CA_ToggleReport],     CA_ToggleReport },
 	  { g_actionTokenStrings[CA_RefreshReport],    CA_RefreshReport },
 	  { g_actionTokenStrings[CA_ClearFilter],      CA_ClearFilter },
+	  { g_actionTokenStrings[CA_SendAll],          CA_SendAll },
+	  { g_actionTokenStrings[CA_SendStatesOnly],   CA_SendStatesOnly },
+	  { g_actionTokenStrings[CA_SendEventsOnly],   CA_SendEventsOnly },
 
 	  // { tokenToName(ST_SettingsVersion),   ST_SettingsVersion },
 